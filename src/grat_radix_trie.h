@@ -40,6 +40,7 @@ extern "C" {
 #endif // #ifdef __cplusplus
 
 //#include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -54,6 +55,9 @@ extern "C" {
 
 #define DEBUG 1
 
+// longest host name (plus NUL) the domain functions will handle
+#define RADIX_DOMAIN_MAX 256
+
 #define grat_log(msg) if (DEBUG > 0) fprintf(stderr, "Error in %s at line %d(%s): %s\n", \
         __FILE__, __LINE__, __func__, msg); 
 
@@ -69,6 +73,71 @@ char * _grat_trie_strndup(const char *input, size_t max);
 
 // END STRING UTILS
 
+// subtree aggregates: 'value' maps a stored value into the aggregate domain and 'combine' must be
+//      associative (sum, min, max, ...), with 'identity' as its neutral element
+typedef long radix_agg_t;
+typedef radix_agg_t(*trie_aggregate_value_callback)(void *value);
+typedef radix_agg_t(*trie_aggregate_combine_callback)(radix_agg_t a, radix_agg_t b);
+
+typedef struct {
+    radix_agg_t identity;
+    trie_aggregate_value_callback value;
+    trie_aggregate_combine_callback combine;
+} radix_aggregate_t;
+
+// negative-lookup filter: a blocked Bloom filter in which every key sets RADIX_FILTER_PROBES bits of
+//      a single 64 byte block, so ruling a key out costs one cache line.  Deletes can't clear bits,
+//      so they are counted and the filter is rebuilt once they pile up
+#define RADIX_FILTER_BLOCK_WORDS 8
+#define RADIX_FILTER_BITS_PER_KEY 10
+#define RADIX_FILTER_PROBES 6
+
+typedef struct {
+    uint64_t *blocks;       // 64 byte aligned
+    void *memory;           // what was actually allocated
+    size_t num_blocks;
+    size_t keys;            // keys added since the last rebuild, deleted ones included
+    size_t deletes;         // keys deleted since the last rebuild
+
+    // lookup counters, only kept after trie_count_filter_lookups since every lookup would otherwise
+    //      write to them (a store per read, and a race between threads sharing the trie)
+    int counting;
+    size_t lookups;
+    size_t rejected;
+    size_t false_positives;
+    size_t rebuilds;
+} radix_filter_t;
+
+typedef struct {
+    size_t lookups;             // trie_get_key calls that went through the filter, when counting
+    size_t rejected;            // misses answered by the filter alone
+    size_t false_positives;     // misses the filter let through
+    size_t rebuilds;
+    size_t memory;              // bytes
+    double hit_rate;            // share of lookups answered by the filter alone
+    double false_positive_rate; // share of misses the filter let through
+} radix_filter_stats_t;
+
+// Merkle hashes: with hashing on, every node carries a hash of its value and of its children's keys
+//      and hashes (but not of its own key, so that splits and merges can carry it over like the
+//      count).  Equal hashes mean equal subtrees, which is what lets trie_diff skip them.  The
+//      hash and the cached key hash live in every node, so they cost 16 bytes per node whether
+//      hashing is on or not; with it off they are just never computed
+typedef uint64_t(*trie_hash_value_callback)(void *value);
+
+// tombstones: with them on, a delete only clears the value and lists the node on the trie's dirty
+//      list, and trie_maintain does the unlinking, merging and freeing later in batches
+struct radix_node;
+
+// per-trie state, kept next to the root node in a radix_root_t
+typedef struct {
+    const radix_aggregate_t *aggregate;
+    radix_filter_t *filter;
+    trie_hash_value_callback value_hash;    // NULL unless hashing is on
+    int tombstones;
+    struct radix_node *dirty;               // first node waiting for trie_maintain, or NULL
+} radix_info_t;
+
 typedef struct radix_node {
     char *key;
     void *val;
@@ -77,8 +146,23 @@ typedef struct radix_node {
     struct radix_node *child;
     struct radix_node *left;
     struct radix_node *right;
+
+    size_t count;       // number of keys in this subtree, including this node
+    radix_agg_t agg;    // aggregate of the values in this subtree
+    uint64_t hash;      // Merkle hash of this subtree, when hashing is on (always allocated)
+    uint64_t key_hash;  // hash of key, 0 until _trie_hash_node first needs it or after a relabel
+    struct radix_node *dirty; // next node on the dirty list (itself if last), NULL if not listed
 } radix_t;
 
+// what trie_new actually allocates: the root node with the per-trie state behind it, so that no
+//      other node pays for it.  Only a root from trie_new may be passed to RADIX_INFO
+typedef struct {
+    radix_t node;
+    radix_info_t info;
+} radix_root_t;
+
+#define RADIX_INFO(root_node) (&((radix_root_t *)(root_node))->info)
+
 typedef struct {
     radix_t *root_node;
     radix_t *node;
@@ -88,9 +172,37 @@ typedef struct {
 } radix_iterator_t;
 
 typedef void(*trie_value_callback)(void *value);
+// returns the value to keep when both tries hold the same key
+typedef void *(*trie_conflict_callback)(void *dst_value, void *src_value);
+// called for every key that differs between two tries, with a NULL value on the side missing it
+typedef void(*trie_diff_callback)(const char *key, void *a_value, void *b_value);
+// deltas carry values as bytes: encode returns how many bytes value takes, writing them to buf if
+//      they fit in buf_len, and decode turns them back into a value
+typedef size_t(*trie_value_encode_callback)(void *value, char *buf, size_t buf_len);
+typedef void *(*trie_value_decode_callback)(const char *buf, size_t len);
+
+// a growable byte buffer, kept NUL terminated
+typedef struct {
+    char *data;
+    size_t len;
+    size_t size;
+} radix_buf_t;
+
+typedef struct {
+    radix_buf_t key;
+    trie_hash_value_callback value_hash;    // set when both tries hash their values the same way
+    trie_diff_callback callback;
+    size_t count;
+
+    // delta output, front coded against the previous key
+    radix_buf_t *delta;
+    radix_buf_t last_key;
+    trie_value_encode_callback encode;
+} radix_diff_t;
 
 // PUBLIC METHOD DEFINITIONS/PROTOTYPES
 radix_t * trie_new ();
+radix_t * trie_new_aggregate (const radix_aggregate_t *aggregate);
 void trie_destroy (radix_t *trie);
 void * trie_set_key (radix_t *root_node, const char *key, void *val );
 void * trie_get_key (radix_t *root_node, const char *key);
@@ -98,15 +210,48 @@ void * trie_delete_key (radix_t *root_node, const char *key);
 void * trie_get_longest_match (radix_t *root_node, const char *key, char **remainder);
 size_t trie_recurse_prefix (radix_t *root_node, const char *prefix, trie_value_callback callback);
 size_t trie_recurse (radix_t *root_node, trie_value_callback callback);
+size_t trie_count_prefix (radix_t *root_node, const char *prefix);
+size_t trie_rank (radix_t *root_node, const char *key);
+void * trie_select (radix_t *root_node, size_t index, char *key, size_t key_len);
+radix_agg_t trie_aggregate_prefix (radix_t *root_node, const char *prefix);
+radix_agg_t trie_aggregate_sum (radix_agg_t a, radix_agg_t b);
+radix_agg_t trie_aggregate_min (radix_agg_t a, radix_agg_t b);
+radix_agg_t trie_aggregate_max (radix_agg_t a, radix_agg_t b);
+radix_t * trie_union (radix_t *dst_root, radix_t *src_root, trie_conflict_callback resolve);
+radix_t * trie_intersect (radix_t *dst_root, radix_t *src_root, trie_conflict_callback resolve,
+        trie_value_callback discard);
+radix_t * trie_difference (radix_t *dst_root, radix_t *src_root, trie_value_callback discard);
+radix_t * trie_detach_prefix (radix_t *root_node, const char *prefix);
+void trie_free_subtree (radix_t *subtree, trie_value_callback value_destructor);
+size_t trie_delete_prefix (radix_t *root_node, const char *prefix,
+        trie_value_callback value_destructor);
+void * trie_set_domain (radix_t *root_node, const char *host, void *val);
+void * trie_get_domain (radix_t *root_node, const char *host);
+void * trie_delete_domain (radix_t *root_node, const char *host);
+void * trie_match_suffix (radix_t *root_node, const char *host);
+void * trie_match_domain (radix_t *root_node, const char *host);
+size_t trie_match_domains (radix_t *root_node, const char **hosts, size_t num_hosts,
+        void **results);
+void trie_enable_filter (radix_t *root_node);
+void trie_disable_filter (radix_t *root_node);
+void trie_rebuild_filter (radix_t *root_node);
+void trie_count_filter_lookups (radix_t *root_node, int on);
+int trie_filter_stats (radix_t *root_node, radix_filter_stats_t *stats);
+void trie_enable_tombstones (radix_t *root_node);
+void trie_disable_tombstones (radix_t *root_node);
+int trie_maintain (radix_t *root_node, size_t budget);
+void trie_enable_hashing (radix_t *root_node, trie_hash_value_callback value_hash);
+uint64_t trie_hash_pointer (void *value);
+uint64_t trie_hash_string (void *value);
+size_t trie_diff (radix_t *a, radix_t *b, trie_diff_callback callback);
+char * trie_delta (radix_t *a, radix_t *b, trie_value_encode_callback encode, size_t *len);
+long trie_apply_delta (radix_t *root_node, const char *delta, size_t len,
+        trie_value_decode_callback decode, trie_value_callback discard);
 
 // PRIVATE METHODS
 
-radix_t *
-_trie_new_node (const char *key) {
-    radix_t *node;
-
-    node = (radix_t *)malloc(sizeof(radix_t));
-
+void
+_trie_init_node (radix_t *node, const char *key) {
     // set key, all else to NULL
     node->key = strdup(key);
     node->val = NULL;
@@ -114,6 +259,19 @@ _trie_new_node (const char *key) {
     node->child = NULL;
     node->left = NULL;
     node->right = NULL;
+    node->count = 0;
+    node->agg = 0;
+    node->hash = 0;
+    node->key_hash = 0;
+    node->dirty = NULL;
+}
+
+radix_t *
+_trie_new_node (const char *key) {
+    radix_t *node;
+
+    node = (radix_t *)malloc(sizeof(radix_t));
+    _trie_init_node(node, key);
 
     return node;
 }
@@ -126,6 +284,15 @@ _trie_free_node (radix_t *node) {
     return;
 }
 
+// put a node on the dirty list (if it isn't already)
+void
+_trie_mark_dirty (radix_info_t *info, radix_t *node) {
+    if (node->dirty == NULL) {
+        node->dirty = info->dirty != NULL ? info->dirty : node;
+        info->dirty = node;
+    }
+}
+
 inline void
 _trie_add_child (radix_t *parent, radix_t *new_child) {
     radix_t *child = parent->child;
@@ -173,6 +340,127 @@ _trie_add_child (radix_t *parent, radix_t *new_child) {
     }
 }
 
+// remove a node from its parent's list of children
+void
+_trie_unlink_node (radix_t *node) {
+    if (node->left != NULL) {
+        node->left->right = node->right;
+    } else if (node->parent != NULL) {
+        // node was the first child, so the parent has to point at its next sibling
+        node->parent->child = node->right;
+    }
+    if (node->right != NULL) {
+        node->right->left = node->left;
+    }
+    node->parent = NULL;
+    node->left = NULL;
+    node->right = NULL;
+}
+
+uint64_t
+_trie_hash_mix (uint64_t hash, uint64_t data) {
+    hash = (hash ^ data) * 0x9e3779b97f4a7c15ULL;
+    return hash ^ (hash >> 29);
+}
+
+// a node's key hash is worked out once and kept until the key changes, so rehashing a parent after
+//      every write doesn't walk all its children's keys again
+uint64_t
+_trie_key_hash (radix_t *node) {
+    uint64_t hash = 2;
+    const char *key;
+
+    if (node->key_hash == 0) {
+        for (key = node->key; key[0] != 0; key++) {
+            hash = _trie_hash_mix(hash, (unsigned char)key[0]);
+        }
+        node->key_hash = hash | 1;
+    }
+
+    return node->key_hash;
+}
+
+// a node's hash covers its value and its children's keys and hashes, in order
+uint64_t
+_trie_hash_node (radix_t *node, trie_hash_value_callback value_hash) {
+    uint64_t hash = node->val != NULL ? _trie_hash_mix(1, value_hash(node->val)) : 0;
+    radix_t *child;
+
+    for (child = node->child; child != NULL; child = child->right) {
+        hash = _trie_hash_mix(hash, _trie_key_hash(child));
+        hash = _trie_hash_mix(hash, child->hash);
+    }
+
+    return hash;
+}
+
+// recombine a node's aggregate from its own value and its children's aggregates
+void
+_trie_combine_node (radix_t *node, const radix_aggregate_t *aggregate) {
+    radix_t *child;
+
+    node->agg = node->val != NULL ? aggregate->value(node->val) : aggregate->identity;
+    for (child = node->child; child != NULL; child = child->right) {
+        node->agg = aggregate->combine(node->agg, child->agg);
+    }
+}
+
+// recompute a node's key count, aggregate and hash from its own value and its children
+void
+_trie_update_node (radix_t *node, const radix_info_t *info) {
+    radix_t *child;
+
+    node->count = node->val != NULL ? 1 : 0;
+    for (child = node->child; child != NULL; child = child->right) {
+        node->count += child->count;
+    }
+
+    if (info != NULL && info->aggregate != NULL) {
+        _trie_combine_node(node, info->aggregate);
+    }
+    if (info != NULL && info->value_hash != NULL) {
+        node->hash = _trie_hash_node(node, info->value_hash);
+    }
+}
+
+// recompute counts, aggregates and hashes from a modified node up to the root
+void
+_trie_update_path (radix_t *node, const radix_info_t *info) {
+    while (node != NULL) {
+        _trie_update_node(node, info);
+        node = node->parent;
+    }
+}
+
+// recompute a node whose value or children changed, then fix up its ancestors, whose key counts
+//      just move by 'delta'.  An ancestor's aggregate is only recombined while the one below it
+//      changed (the parent always is, a new child starts out without a real aggregate), and
+//      hashes, when on, change all the way up
+void
+_trie_update_path_delta (radix_t *node, long delta, const radix_info_t *info) {
+    const radix_aggregate_t *aggregate = info->aggregate;
+    int hashing = info->value_hash != NULL;
+    int combine = aggregate != NULL;
+    radix_agg_t agg;
+
+    _trie_update_node(node, info);
+
+    for (node = node->parent; node != NULL; node = node->parent) {
+        if (delta == 0 && !combine && !hashing) {
+            break;
+        }
+        node->count += delta;
+        if (combine) {
+            agg = node->agg;
+            _trie_combine_node(node, aggregate);
+            combine = node->agg != agg;
+        }
+        if (hashing) {
+            node->hash = _trie_hash_node(node, info->value_hash);
+        }
+    }
+}
+
 inline int
 _trie_string_cmp (const char *a, const char *b) {
     size_t bytes = 0;
@@ -267,10 +555,29 @@ _trie_get_node (radix_t *root_node, const char *key) {
     return NULL;
 }
 
+// returns the node whose subtree holds every key starting with prefix, or NULL
+radix_t *
+_trie_get_prefix_node (radix_t *root_node, const char *prefix) {
+    char *remainder;
+    size_t len_match;
+    radix_t *full_match_node, *partial_match_node;
+
+    remainder = _trie_get_longest_match(root_node, prefix, &full_match_node,
+            &partial_match_node, &len_match);
+
+    if (remainder[0] != 0) {
+        return NULL;
+    }
+
+    // the prefix either ended exactly on a node or part way through the partial match's key,
+    //      either way that node's subtree is everything under the prefix
+    return partial_match_node;
+}
+
 // split one node into two, using the first 'len' bytes of the key to make the new parent
 radix_t *
-_trie_split_node(radix_t *node, size_t len) {
-    radix_t *new_child;
+_trie_split_node(radix_t *node, size_t len, radix_info_t *info) {
+    radix_t *new_child, *child;
     char *new_key;
     size_t i;
 
@@ -288,11 +595,25 @@ _trie_split_node(radix_t *node, size_t len) {
     new_child->val = node->val;
     new_child->child = node->child;
     new_child->parent = node;
+    for (child = new_child->child; child != NULL; child = child->right) {
+        child->parent = new_child;
+    }
+
+    // the subtree itself didn't change, it just hangs one level lower
+    new_child->count = node->count;
+    new_child->agg = node->agg;
+    new_child->hash = node->hash;
+
+    // a listed tombstone's emptiness moves down with its contents
+    if (node->dirty != NULL && new_child->val == NULL) {
+        _trie_mark_dirty(info, new_child);
+    }
 
     // make a new key for the new parent node
     new_key = strndup(node->key, len);
     free(node->key);
     node->key = new_key;
+    node->key_hash = 0;
     node->val = NULL; // wipe out the value because it's associated with the end of the key
     node->child = new_child;
 
@@ -330,7 +651,7 @@ _trie_get_or_create_node (radix_t *root_node, const char *path_input) {
 
     // at this point the last node matched partially, so we need to split the node that partially
     //      matched
-    partial_match_node = _trie_split_node(partial_match_node, len_match);
+    partial_match_node = _trie_split_node(partial_match_node, len_match, RADIX_INFO(root_node));
     if (remainder[0]) {
         // some of the path was left, so we're a sibling of the second part of the partial match
         new_node = _trie_new_node(remainder);
@@ -344,7 +665,7 @@ _trie_get_or_create_node (radix_t *root_node, const char *path_input) {
 // merge a child with no siblings into its parent
 void
 _trie_merge_node_with_child(radix_t *node) {
-    radix_t *child;
+    radix_t *child, *grandchild;
     char *new_key;
     size_t len;
 
@@ -363,10 +684,18 @@ _trie_merge_node_with_child(radix_t *node) {
         // set the new key
         free(node->key);
         node->key = new_key;
+        node->key_hash = 0;
     
-        // take ownership of the grandchildren and free the child
+        // take ownership of the child's value and grandchildren and free the child
         child = node->child;
+        node->val = child->val;
         node->child = child->child;
+        for (grandchild = node->child; grandchild != NULL; grandchild = grandchild->right) {
+            grandchild->parent = node;
+        }
+        node->count = child->count;
+        node->agg = child->agg;
+        node->hash = child->hash;
         _trie_free_node(child);
     }
 
@@ -375,31 +704,35 @@ _trie_merge_node_with_child(radix_t *node) {
 
 // delete a node and clean up if necessary
 void *
-_trie_delete_node (radix_t *node) {
+_trie_delete_node (radix_t *node, const radix_info_t *info) {
     void *val = node->val;
+    radix_t *parent;
+
+    long delta = val != NULL ? -1 : 0;
 
     node->val = NULL;
 
     // don't delete the root node
     if (node->parent == NULL) {
+        _trie_update_path_delta(node, delta, info);
         return val;
     }
 
     // merge with its child node if necessary
     if (node->child != NULL) {
         _trie_merge_node_with_child(node);
+        _trie_update_path_delta(node, delta, info);
     } else {
         // we have no children, so just introduce our siblings to one another
-        if (node->left != NULL) {
-            node->left->right = node->right;
-        }
-        if (node->right != NULL) {
-            node->right->left = node->left;
-        }
-        node->right = NULL;
-        node->left = NULL;
-
+        parent = node->parent;
+        _trie_unlink_node(node);
         _trie_free_node(node);
+
+        // a branch node left with a single child gets folded into that child
+        if (parent->val == NULL) {
+            _trie_merge_node_with_child(parent);
+        }
+        _trie_update_path_delta(parent, delta, info);
     }
 
     return val;
@@ -553,98 +886,934 @@ _trie_dump_contents (radix_t *root_node) {
     _trie_destroy_iterator(iter);
 }
 
-// FIXME: this could be a very large stack...  find a better solution
+// free a detached subtree, handing each value to callback (if any) first.  Rather than recursing,
+//      each node's children are spliced into the sibling chain in front of its right sibling, so the
+//      whole subtree is freed as one flat list with no extra memory
 void
-_trie_recursively_free(radix_t *node) {
-    if (node == NULL) {
-        return;
+_trie_free_subtree (radix_t *node, trie_value_callback callback) {
+    radix_t *last, *next;
+
+    while (node != NULL) {
+        if (node->child != NULL) {
+            for (last = node->child; last->right != NULL; last = last->right) {
+                continue;
+            }
+            last->right = node->right;
+            node->right = node->child;
+            node->child = NULL;
+        }
+
+        if (callback != NULL && node->val != NULL) {
+            callback(node->val);
+        }
+        next = node->right;
+        _trie_free_node(node);
+        node = next;
     }
+}
+
+// recompute counts, aggregates and hashes for a whole subtree, children first
+void
+_trie_update_subtree (radix_t *node, const radix_info_t *info) {
+    radix_t *child;
 
-    _trie_recursively_free(node->child);
-    _trie_recursively_free(node->right);
-    _trie_free_node(node);
+    for (child = node->child; child != NULL; child = child->right) {
+        _trie_update_subtree(child, info);
+    }
+    _trie_update_node(node, info);
 }
 
-// PUBLIC METHOD IMPLEMENTATIONS
+// restore path compression on a (non-root) node that may have lost its value or children
+void
+_trie_compress_node (radix_t *node) {
+    if (node->parent == NULL || node->val != NULL) {
+        return;
+    }
 
-// get a new trie root
-radix_t *
-trie_new () {
-    return _trie_new_node("");
+    if (node->child == NULL) {
+        _trie_unlink_node(node);
+        _trie_free_node(node);
+    } else {
+        _trie_merge_node_with_child(node);
+    }
 }
 
+// remove a child of a node being intersected, along with everything under it
 void
-trie_destroy (radix_t *root_node) {
-    _trie_recursively_free(root_node);
+_trie_drop_subtree (radix_t *node, trie_value_callback discard) {
+    _trie_unlink_node(node);
+    _trie_free_subtree(node, discard);
 }
 
-// returns the value that was set
-void *
-trie_set_key (radix_t *root_node, const char *key, void *val ) {
-    // FIXME: if node is being set to NULL, treat as delete(?)
+void _trie_union_child (radix_t *dst, radix_t *src, trie_conflict_callback resolve,
+        radix_info_t *info, int same_info);
+
+// merge src into dst where both nodes spell the same key, emptying src along the way
+void
+_trie_union_node (radix_t *dst, radix_t *src, trie_conflict_callback resolve,
+        radix_info_t *info, int same_info) {
+    radix_t *child;
+
+    if (src->val != NULL) {
+        if (dst->val != NULL && resolve != NULL) {
+            dst->val = resolve(dst->val, src->val);
+        } else {
+            dst->val = src->val;
+        }
+        src->val = NULL;
+    }
+
+    while ((child = src->child) != NULL) {
+        _trie_unlink_node(child);
+        _trie_union_child(dst, child, resolve, info, same_info);
+    }
+
+    _trie_update_node(dst, info);
+}
+
+// add the detached src subtree below dst, grafting it whole when dst has nothing there
+void
+_trie_union_child (radix_t *dst, radix_t *src, trie_conflict_callback resolve,
+        radix_info_t *info, int same_info) {
     radix_t *node;
+    char *new_key;
+    size_t match_len;
 
-    node = _trie_get_or_create_node(root_node, key);
-    node->val = val;
+    for (node = dst->child; node != NULL && node->key[0] != src->key[0]; node = node->right) {
+        continue;
+    }
 
-    return node->val;
+    if (node == NULL) {
+        _trie_add_child(dst, src);
+        if (!same_info) {
+            _trie_update_subtree(src, info);
+        }
+        return;
+    }
+
+    match_len = _trie_string_cmp(node->key, src->key);
+    if (node->key[match_len] != 0) {
+        // make the dst node end where the two keys stop agreeing
+        node = _trie_split_node(node, match_len, info);
+    }
+
+    if (src->key[match_len] == 0) {
+        _trie_union_node(node, src, resolve, info, same_info);
+        _trie_free_node(src);
+    } else {
+        // src continues past the dst node, so it belongs among the dst node's children
+        new_key = strdup(src->key + match_len);
+        free(src->key);
+        src->key = new_key;
+        src->key_hash = 0;
+        _trie_union_child(node, src, resolve, info, same_info);
+        _trie_update_node(node, info);
+    }
 }
 
-// returns the value associated with the key, or NULL
-void *
-trie_get_key (radix_t *root_node, const char *key) {
-    char *remainder;
-    void *val;
+void _trie_intersect_child (radix_t *node, radix_t *src, size_t offset,
+        trie_conflict_callback resolve, trie_value_callback discard,
+        radix_info_t *info);
 
-    val = trie_get_longest_match(root_node, key, &remainder);
-    if (remainder[0] == 0) {
-        return val;
+// keep only the part of dst's subtree that is also in src, where dst's key ends at src->key[offset]
+//      (which is the end of src's key when the two nodes line up)
+void
+_trie_intersect_node (radix_t *dst, radix_t *src, size_t offset, trie_conflict_callback resolve,
+        trie_value_callback discard, radix_info_t *info) {
+    radix_t *node, *next, *src_child;
+    const char *src_key = src->key + offset;
+
+    if (dst->val != NULL) {
+        if (src_key[0] != 0 || src->val == NULL) {
+            if (discard != NULL) {
+                discard(dst->val);
+            }
+            dst->val = NULL;
+        } else if (resolve != NULL) {
+            dst->val = resolve(dst->val, src->val);
+        }
     }
-    return NULL;
+
+    for (node = dst->child; node != NULL; node = next) {
+        next = node->right;
+
+        if (src_key[0] == 0) {
+            for (src_child = src->child; src_child != NULL && src_child->key[0] != node->key[0];
+                    src_child = src_child->right) {
+                continue;
+            }
+            if (src_child == NULL) {
+                _trie_drop_subtree(node, discard);
+            } else {
+                _trie_intersect_child(node, src_child, 0, resolve, discard, info);
+            }
+        } else if (node->key[0] == src_key[0]) {
+            _trie_intersect_child(node, src, offset, resolve, discard, info);
+        } else {
+            _trie_drop_subtree(node, discard);
+        }
+    }
+
+    _trie_update_node(dst, info);
 }
 
-// returns the value contained by key after deleting node
-void *
-trie_delete_key (radix_t *root_node, const char *key) {
-    radix_t *node;
+// intersect a child of dst whose key starts with the same byte as src->key[offset]
+void
+_trie_intersect_child (radix_t *node, radix_t *src, size_t offset, trie_conflict_callback resolve,
+        trie_value_callback discard, radix_info_t *info) {
+    size_t match_len = _trie_string_cmp(node->key, src->key + offset);
+
+    if (node->key[match_len] != 0) {
+        if (src->key[offset + match_len] != 0) {
+            // the keys diverge, so nothing under this node is in src
+            _trie_drop_subtree(node, discard);
+            return;
+        }
+        // src's key ends inside this node's key, split it so the two line up
+        node = _trie_split_node(node, match_len, info);
+    }
 
-    node = _trie_get_node(root_node, key);
-    if (node != NULL) {
-        return _trie_delete_node(node);
+    _trie_intersect_node(node, src, offset + match_len, resolve, discard, info);
+    _trie_compress_node(node);
+}
+
+void _trie_difference_child (radix_t *node, radix_t *src, size_t offset,
+        trie_value_callback discard, radix_info_t *info);
+
+// remove every key in src from dst's subtree, where dst's key ends at src->key[offset]
+void
+_trie_difference_node (radix_t *dst, radix_t *src, size_t offset, trie_value_callback discard,
+        radix_info_t *info) {
+    radix_t *node, *next, *src_child;
+    const char *src_key = src->key + offset;
+
+    if (dst->val != NULL && src_key[0] == 0 && src->val != NULL) {
+        if (discard != NULL) {
+            discard(dst->val);
+        }
+        dst->val = NULL;
     }
 
-    return NULL;
+    for (node = dst->child; node != NULL; node = next) {
+        next = node->right;
+
+        if (src_key[0] == 0) {
+            for (src_child = src->child; src_child != NULL && src_child->key[0] != node->key[0];
+                    src_child = src_child->right) {
+                continue;
+            }
+            if (src_child != NULL) {
+                _trie_difference_child(node, src_child, 0, discard, info);
+            }
+        } else if (node->key[0] == src_key[0]) {
+            _trie_difference_child(node, src, offset, discard, info);
+        }
+    }
+
+    _trie_update_node(dst, info);
 }
 
-// returns the value that was found and key remainder
-void *
-trie_get_longest_match (radix_t *root_node, const char *key, char **full_match_remainder) {
-    char *remainder;
-    radix_t *full_match_node, *partial_match_node;
-    size_t len_match;
+// subtract src from a child of dst whose key starts with the same byte as src->key[offset]
+void
+_trie_difference_child (radix_t *node, radix_t *src, size_t offset, trie_value_callback discard,
+        radix_info_t *info) {
+    size_t match_len = _trie_string_cmp(node->key, src->key + offset);
+
+    if (node->key[match_len] != 0) {
+        if (src->key[offset + match_len] != 0) {
+            // the keys diverge, so nothing under this node is in src
+            return;
+        }
+        node = _trie_split_node(node, match_len, info);
+    }
 
-    remainder = _trie_get_longest_match(root_node, key, &full_match_node,
-            &partial_match_node, &len_match);
+    _trie_difference_node(node, src, offset + match_len, discard, info);
+    _trie_compress_node(node);
+}
 
-    // partial match was the same
-    if (partial_match_node == full_match_node) {
-        *full_match_remainder = remainder;
-        return full_match_node->val;
+// write host into key with its labels in reverse order ("www.example.com" becomes
+//      "com.example.www"), lower cased and without a trailing dot.  Returns the length, or -1 if it
+//      doesn't fit
+int
+_trie_domain_key (const char *host, char *key, size_t key_len) {
+    size_t len, label_end, label_start, out, i;
+
+    len = strlen(host);
+    if (len > 0 && host[len - 1] == '.') {
+        len--;
+    }
+    if (len + 1 > key_len) {
+        return -1;
     }
 
-    // 
+    out = 0;
+    label_end = len;
+    while (1) {
+        label_start = label_end;
+        while (label_start > 0 && host[label_start - 1] != '.') {
+            label_start--;
+        }
+        for (i = label_start; i < label_end; i++) {
+            key[out++] = (host[i] >= 'A' && host[i] <= 'Z') ? host[i] - 'A' + 'a' : host[i];
+        }
+        if (label_start == 0) {
+            break;
+        }
+        key[out++] = '.';
+        label_end = label_start - 1;
+    }
+    key[out] = 0;
 
-    return NULL;
+    return out;
 }
 
-// returns how many nodes matching a given prefix were affected by a functionn pointer calback that
-// takes in the node's value.  Should have another function that calls this with no prefix in order
-// to apply callback to all nodes
-size_t
-trie_recurse_prefix (radix_t *root_node, const char *prefix, trie_value_callback callback) {
-    // get the longest partial match for prefix, use prefix as the root node
+// move a position in the trie (a node and how much of its key has been matched) forward over
+//      len bytes of s, returns 0 if the trie doesn't go that way
+int
+_trie_domain_advance (radix_t **node, size_t *pos, const char *s, size_t len) {
+    radix_t *child;
+    size_t i;
 
-    return 0;
+    for (i = 0; i < len; i++) {
+        if ((*node)->key[*pos] != 0) {
+            if ((*node)->key[*pos] != s[i]) {
+                return 0;
+            }
+            (*pos)++;
+            continue;
+        }
+
+        for (child = (*node)->child; child != NULL && child->key[0] != s[i]; child = child->right) {
+            continue;
+        }
+        if (child == NULL) {
+            return 0;
+        }
+        *node = child;
+        *pos = 1;
+    }
+
+    return 1;
+}
+
+void * _trie_domain_match_label (radix_t *node, size_t pos, const char *key, int wildcards,
+        int depth, int *best_depth);
+
+// a label has just been matched: the rule ending here (if any) matches, unless a rule going
+//      further down the key matches too
+void *
+_trie_domain_match_rest (radix_t *node, size_t pos, const char *key, int wildcards, int depth,
+        int *best_depth) {
+    void *val = NULL;
+    void *deeper;
+
+    if (node->key[pos] == 0 && node->val != NULL) {
+        val = node->val;
+        *best_depth = depth;
+    }
+
+    if (key[0] == '.' && _trie_domain_advance(&node, &pos, key, 1)) {
+        deeper = _trie_domain_match_label(node, pos, key + 1, wildcards, depth, best_depth);
+        if (deeper != NULL) {
+            val = deeper;
+        }
+    }
+
+    return val;
+}
+
+// match the label at the start of key, literally and (if wildcards is set) against a '*' rule
+//      label.  Returns the value of the most specific matching rule, which is the deepest one,
+//      with the literal match winning a tie
+void *
+_trie_domain_match_label (radix_t *node, size_t pos, const char *key, int wildcards, int depth,
+        int *best_depth) {
+    radix_t *wild_node = node;
+    size_t wild_pos = pos;
+    size_t len = strcspn(key, ".");
+    int literal_depth = -1;
+    int wild_depth = -1;
+    void *literal = NULL;
+    void *wild = NULL;
+
+    if (_trie_domain_advance(&node, &pos, key, len)) {
+        literal = _trie_domain_match_rest(node, pos, key + len, wildcards, depth + 1,
+                &literal_depth);
+    }
+    if (wildcards && _trie_domain_advance(&wild_node, &wild_pos, "*", 1)) {
+        wild = _trie_domain_match_rest(wild_node, wild_pos, key + len, wildcards, depth + 1,
+                &wild_depth);
+    }
+
+    if (wild != NULL && (literal == NULL || wild_depth > literal_depth)) {
+        *best_depth = wild_depth;
+        return wild;
+    }
+    if (literal != NULL) {
+        *best_depth = literal_depth;
+    }
+    return literal;
+}
+
+void *
+_trie_domain_match (radix_t *root_node, const char *host, int wildcards) {
+    char key[RADIX_DOMAIN_MAX];
+    int depth;
+
+    if (_trie_domain_key(host, key, sizeof(key)) <= 0) {
+        return NULL;
+    }
+
+    return _trie_domain_match_label(root_node, 0, key, wildcards, 0, &depth);
+}
+
+// filter keys are hashed a label at a time, so a walk of the trie can hash as it goes
+uint64_t
+_trie_filter_hash (uint64_t hash, const char *key) {
+    for (; key[0] != 0; key++) {
+        hash = (hash ^ (unsigned char)key[0]) * 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+#define RADIX_FILTER_SEED 0xcbf29ce484222325ULL
+
+// finish a hash and return the block it lands in, leaving the bits to set in *bits
+uint64_t *
+_trie_filter_block (radix_filter_t *filter, uint64_t hash, uint64_t *bits) {
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdULL;
+    hash ^= hash >> 33;
+    *bits = hash * 0xc4ceb9fe1a85ec53ULL;
+
+    return filter->blocks + RADIX_FILTER_BLOCK_WORDS
+            * (size_t)(((hash >> 32) * filter->num_blocks) >> 32);
+}
+
+void
+_trie_filter_add (radix_filter_t *filter, uint64_t hash) {
+    uint64_t bits;
+    uint64_t *block = _trie_filter_block(filter, hash, &bits);
+    int i;
+
+    for (i = 0; i < RADIX_FILTER_PROBES; i++, bits >>= 9) {
+        block[(bits >> 6) & 7] |= (uint64_t)1 << (bits & 63);
+    }
+    filter->keys++;
+}
+
+int
+_trie_filter_check (radix_filter_t *filter, uint64_t hash) {
+    uint64_t bits;
+    uint64_t *block = _trie_filter_block(filter, hash, &bits);
+    int i;
+
+    for (i = 0; i < RADIX_FILTER_PROBES; i++, bits >>= 9) {
+        if ((block[(bits >> 6) & 7] & ((uint64_t)1 << (bits & 63))) == 0) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+void
+_trie_filter_add_subtree (radix_filter_t *filter, radix_t *node, uint64_t hash) {
+    radix_t *child;
+
+    hash = _trie_filter_hash(hash, node->key);
+    if (node->val != NULL) {
+        _trie_filter_add(filter, hash);
+    }
+    for (child = node->child; child != NULL; child = child->right) {
+        _trie_filter_add_subtree(filter, child, hash);
+    }
+}
+
+// returns the trie's filter, if it has one
+radix_filter_t *
+_trie_get_filter (radix_t *root_node) {
+    return RADIX_INFO(root_node)->filter;
+}
+
+// count keys removed behind the filter's back, rebuilding it once half of what it holds is gone
+void
+_trie_filter_deleted (radix_t *root_node, size_t deleted) {
+    radix_filter_t *filter = _trie_get_filter(root_node);
+
+    if (filter == NULL || deleted == 0) {
+        return;
+    }
+    filter->deletes += deleted;
+    if (filter->deletes * 2 > filter->keys) {
+        trie_rebuild_filter(root_node);
+    }
+}
+
+// restore compression around a node from the dirty list.  Only the node itself, or a child that
+//      isn't listed, is ever freed here, so the list never points at freed memory
+void
+_trie_maintain_node (radix_info_t *info, radix_t *node) {
+    radix_t *parent = node->parent;
+
+    if (parent == NULL) {
+        return;
+    }
+
+    // counts and aggregates already left the tombstone out, only hashes cover the keys below
+    if (node->val == NULL && node->child == NULL) {
+        _trie_unlink_node(node);
+        _trie_free_node(node);
+        if (info->value_hash != NULL) {
+            _trie_update_path(parent, info);
+        }
+    } else if (node->val == NULL && node->child->right == NULL) {
+        if (node->child->dirty != NULL) {
+            // the child lists this node again once it has been seen to
+            return;
+        }
+        _trie_merge_node_with_child(node);
+        if (info->value_hash != NULL) {
+            _trie_update_path(parent, info);
+        }
+    }
+
+    // the parent may be left a valueless node with one child or none
+    if (parent->parent != NULL && parent->val == NULL &&
+            (parent->child == NULL || parent->child->right == NULL)) {
+        _trie_mark_dirty(info, parent);
+    }
+}
+
+// bulk operations free and move nodes wholesale, so they start from a clean trie
+void
+_trie_flush_dirty (radix_t *root_node) {
+    if (RADIX_INFO(root_node)->dirty != NULL) {
+        trie_maintain(root_node, 0);
+    }
+}
+
+// make room for len more bytes (and the NUL)
+void
+_trie_buf_reserve (radix_buf_t *buf, size_t len) {
+    if (buf->len + len + 1 > buf->size) {
+        buf->size = (buf->len + len + 1) * 2;
+        buf->data = (char *)realloc(buf->data, buf->size);
+    }
+}
+
+void
+_trie_buf_append (radix_buf_t *buf, const char *data, size_t len) {
+    _trie_buf_reserve(buf, len);
+    if (len > 0) {
+        memcpy(buf->data + buf->len, data, len);
+    }
+    buf->len += len;
+    buf->data[buf->len] = 0;
+}
+
+void
+_trie_buf_truncate (radix_buf_t *buf, size_t len) {
+    buf->len = len;
+    if (buf->data != NULL) {
+        buf->data[len] = 0;
+    }
+}
+
+// lengths in deltas are LEB128 varints
+void
+_trie_buf_put_varint (radix_buf_t *buf, size_t value) {
+    char byte;
+
+    do {
+        byte = value & 0x7f;
+        value >>= 7;
+        if (value != 0) {
+            byte |= 0x80;
+        }
+        _trie_buf_append(buf, &byte, 1);
+    } while (value != 0);
+}
+
+// returns how many bytes were read, 0 if the varint runs off the end
+size_t
+_trie_get_varint (const char *data, size_t len, size_t *value) {
+    size_t i;
+    int shift = 0;
+
+    *value = 0;
+    for (i = 0; i < len && shift < 64; i++, shift += 7) {
+        *value |= (size_t)(data[i] & 0x7f) << shift;
+        if ((data[i] & 0x80) == 0) {
+            return i + 1;
+        }
+    }
+    return 0;
+}
+
+// a delta record: shared prefix length, suffix length, suffix, then the value's length plus one
+//      and its bytes (or a single 0 for a delete)
+void
+_trie_delta_put (radix_diff_t *diff, void *value) {
+    radix_buf_t *delta = diff->delta;
+    size_t shared = 0;
+    size_t len;
+
+    while (shared < diff->last_key.len && shared < diff->key.len &&
+            diff->last_key.data[shared] == diff->key.data[shared]) {
+        shared++;
+    }
+    _trie_buf_put_varint(delta, shared);
+    _trie_buf_put_varint(delta, diff->key.len - shared);
+    _trie_buf_append(delta, diff->key.data + shared, diff->key.len - shared);
+    _trie_buf_truncate(&diff->last_key, 0);
+    _trie_buf_append(&diff->last_key, diff->key.data, diff->key.len);
+
+    if (value == NULL) {
+        _trie_buf_put_varint(delta, 0);
+    } else if (diff->encode == NULL) {
+        _trie_buf_put_varint(delta, sizeof(void *) + 1);
+        _trie_buf_append(delta, (const char *)&value, sizeof(void *));
+    } else {
+        len = diff->encode(value, NULL, 0);
+        _trie_buf_put_varint(delta, len + 1);
+        _trie_buf_reserve(delta, len);
+        diff->encode(value, delta->data + delta->len, len);
+        _trie_buf_truncate(delta, delta->len + len);
+    }
+}
+
+// the values of the current key in both tries, either of which may be NULL
+void
+_trie_diff_report (radix_diff_t *diff, void *a_value, void *b_value) {
+    if (a_value == b_value || (a_value != NULL && b_value != NULL && diff->value_hash != NULL &&
+                diff->value_hash(a_value) == diff->value_hash(b_value))) {
+        return;
+    }
+
+    diff->count++;
+    if (diff->callback != NULL) {
+        diff->callback(diff->key.data, a_value, b_value);
+    }
+    if (diff->delta != NULL) {
+        _trie_delta_put(diff, b_value);
+    }
+}
+
+// report every key below a position (node, offset bytes into its key) that only one trie has
+void
+_trie_diff_side (radix_diff_t *diff, radix_t *node, size_t offset, int in_a) {
+    size_t len = diff->key.len;
+    radix_t *child;
+
+    _trie_buf_append(&diff->key, node->key + offset, strlen(node->key + offset));
+    if (node->val != NULL) {
+        _trie_diff_report(diff, in_a ? node->val : NULL, in_a ? NULL : node->val);
+    }
+    for (child = node->child; child != NULL; child = child->right) {
+        _trie_diff_side(diff, child, 0, in_a);
+    }
+
+    _trie_buf_truncate(&diff->key, len);
+}
+
+// compare two positions that spell the same key.  Either may be partway through a node's key, so
+//      the two tries don't need to be split the same way, and whenever both reach the end of a
+//      node with the same hash there is nothing below to compare
+void
+_trie_diff_at (radix_diff_t *diff, radix_t *a, size_t a_pos, radix_t *b, size_t b_pos) {
+    size_t len = diff->key.len;
+    size_t match_len = _trie_string_cmp(a->key + a_pos, b->key + b_pos);
+    radix_t *a_next, *b_next;
+    int a_end, b_end;
+
+    _trie_buf_append(&diff->key, a->key + a_pos, match_len);
+    a_pos += match_len;
+    b_pos += match_len;
+    a_end = a->key[a_pos] == 0;
+    b_end = b->key[b_pos] == 0;
+
+    if (a_end && b_end && diff->value_hash != NULL && a->hash == b->hash) {
+        _trie_buf_truncate(&diff->key, len);
+        return;
+    }
+
+    _trie_diff_report(diff, a_end ? a->val : NULL, b_end ? b->val : NULL);
+
+    // from here each trie carries on with the node's children, or with the rest of the node's key
+    a_next = a_end ? a->child : a;
+    b_next = b_end ? b->child : b;
+    if (a_end) {
+        a_pos = 0;
+    }
+    if (b_end) {
+        b_pos = 0;
+    }
+
+    while (a_next != NULL || b_next != NULL) {
+        if (b_next == NULL || (a_next != NULL && a_next->key[a_pos] < b_next->key[b_pos])) {
+            _trie_diff_side(diff, a_next, a_pos, 1);
+            a_next = a_end ? a_next->right : NULL;
+        } else if (a_next == NULL || b_next->key[b_pos] < a_next->key[a_pos]) {
+            _trie_diff_side(diff, b_next, b_pos, 0);
+            b_next = b_end ? b_next->right : NULL;
+        } else {
+            _trie_diff_at(diff, a_next, a_pos, b_next, b_pos);
+            a_next = a_end ? a_next->right : NULL;
+            b_next = b_end ? b_next->right : NULL;
+        }
+    }
+
+    _trie_buf_truncate(&diff->key, len);
+}
+
+size_t
+_trie_diff (radix_t *a, radix_t *b, radix_diff_t *diff) {
+    memset(&diff->key, 0, sizeof(diff->key));
+    memset(&diff->last_key, 0, sizeof(diff->last_key));
+    _trie_buf_append(&diff->key, NULL, 0);
+    diff->count = 0;
+    diff->value_hash = NULL;
+
+    // tombstones would keep equal subtrees from hashing the same
+    _trie_flush_dirty(a);
+    _trie_flush_dirty(b);
+    if (RADIX_INFO(a)->value_hash == RADIX_INFO(b)->value_hash) {
+        diff->value_hash = RADIX_INFO(a)->value_hash;
+    }
+
+    _trie_diff_at(diff, a, 0, b, 0);
+
+    free(diff->key.data);
+    free(diff->last_key.data);
+    return diff->count;
+}
+
+// PUBLIC METHOD IMPLEMENTATIONS
+
+// get a new trie root
+radix_t *
+trie_new () {
+    radix_root_t *root = (radix_root_t *)malloc(sizeof(radix_root_t));
+
+    _trie_init_node(&root->node, "");
+    root->info.aggregate = NULL;
+    root->info.filter = NULL;
+    root->info.value_hash = NULL;
+    root->info.tombstones = 0;
+    root->info.dirty = NULL;
+
+    return &root->node;
+}
+
+// get a new trie root that maintains 'aggregate' over every subtree
+radix_t *
+trie_new_aggregate (const radix_aggregate_t *aggregate) {
+    radix_t *root_node = trie_new();
+
+    RADIX_INFO(root_node)->aggregate = aggregate;
+    root_node->agg = aggregate->identity;
+
+    return root_node;
+}
+
+void
+trie_destroy (radix_t *root_node) {
+    trie_disable_filter(root_node);
+    _trie_free_subtree(root_node, NULL);
+}
+
+// put a negative-lookup filter in front of trie_get_key, so that most lookups of missing keys are
+//      answered from one cache line without walking the trie
+void
+trie_enable_filter (radix_t *root_node) {
+    if (RADIX_INFO(root_node)->filter == NULL) {
+        RADIX_INFO(root_node)->filter = (radix_filter_t *)calloc(1, sizeof(radix_filter_t));
+        trie_rebuild_filter(root_node);
+        RADIX_INFO(root_node)->filter->rebuilds = 0;
+    }
+}
+
+void
+trie_disable_filter (radix_t *root_node) {
+    radix_filter_t *filter = _trie_get_filter(root_node);
+
+    if (filter != NULL) {
+        free(filter->memory);
+        free(filter);
+        RADIX_INFO(root_node)->filter = NULL;
+    }
+}
+
+// rebuild the filter from the keys in the trie, with room for as many again.  Done on its own as
+//      keys are added and deleted, but cheap enough to call after a batch of changes.  Does nothing
+//      if the trie has no filter
+void
+trie_rebuild_filter (radix_t *root_node) {
+    radix_filter_t *filter = _trie_get_filter(root_node);
+    size_t bytes;
+
+    if (filter == NULL) {
+        return;
+    }
+
+    filter->num_blocks = (2 * root_node->count * RADIX_FILTER_BITS_PER_KEY + 511) / 512;
+    if (filter->num_blocks == 0) {
+        filter->num_blocks = 1;
+    }
+    bytes = filter->num_blocks * RADIX_FILTER_BLOCK_WORDS * sizeof(uint64_t);
+
+    free(filter->memory);
+    filter->memory = calloc(1, bytes + 63);
+    filter->blocks = (uint64_t *)(((uintptr_t)filter->memory + 63) & ~(uintptr_t)63);
+    filter->keys = 0;
+    filter->deletes = 0;
+    filter->rebuilds++;
+
+    _trie_filter_add_subtree(filter, root_node, RADIX_FILTER_SEED);
+}
+
+// start (on != 0) or stop keeping the lookup counters reported by trie_filter_stats.  Meant for
+//      tuning from a single thread, lookups only ever read the trie while this is off
+void
+trie_count_filter_lookups (radix_t *root_node, int on) {
+    radix_filter_t *filter = _trie_get_filter(root_node);
+
+    if (filter != NULL) {
+        filter->counting = on;
+    }
+}
+
+// fills in stats, returns -1 if the trie has no filter
+int
+trie_filter_stats (radix_t *root_node, radix_filter_stats_t *stats) {
+    radix_filter_t *filter = _trie_get_filter(root_node);
+    size_t misses;
+
+    if (filter == NULL) {
+        return -1;
+    }
+
+    stats->lookups = filter->lookups;
+    stats->rejected = filter->rejected;
+    stats->false_positives = filter->false_positives;
+    stats->rebuilds = filter->rebuilds;
+    stats->memory = sizeof(radix_filter_t) + filter->num_blocks * RADIX_FILTER_BLOCK_WORDS
+            * sizeof(uint64_t) + 63;
+
+    misses = filter->rejected + filter->false_positives;
+    stats->hit_rate = filter->lookups > 0 ? (double)filter->rejected / filter->lookups : 0;
+    stats->false_positive_rate = misses > 0 ? (double)filter->false_positives / misses : 0;
+
+    return 0;
+}
+
+// returns the value that was set
+void *
+trie_set_key (radix_t *root_node, const char *key, void *val ) {
+    // FIXME: if node is being set to NULL, treat as delete(?)
+    radix_filter_t *filter = _trie_get_filter(root_node);
+    radix_t *node;
+    int added;
+
+    node = _trie_get_or_create_node(root_node, key);
+    added = node->val == NULL;
+    node->val = val;
+    _trie_update_path_delta(node, (val != NULL) - !added, RADIX_INFO(root_node));
+
+    if (filter != NULL && added && val != NULL) {
+        _trie_filter_add(filter, _trie_filter_hash(RADIX_FILTER_SEED, key));
+        // grow the filter once it holds more keys than it was sized for
+        if (filter->keys > filter->num_blocks * (512 / RADIX_FILTER_BITS_PER_KEY)) {
+            trie_rebuild_filter(root_node);
+        }
+    }
+
+    return node->val;
+}
+
+// returns the value associated with the key, or NULL
+void *
+trie_get_key (radix_t *root_node, const char *key) {
+    radix_filter_t *filter = _trie_get_filter(root_node);
+    char *remainder;
+    void *val;
+
+    if (filter != NULL) {
+        if (!_trie_filter_check(filter, _trie_filter_hash(RADIX_FILTER_SEED, key))) {
+            if (filter->counting) {
+                filter->lookups++;
+                filter->rejected++;
+            }
+            return NULL;
+        }
+    }
+
+    val = trie_get_longest_match(root_node, key, &remainder);
+    if (remainder[0] != 0) {
+        val = NULL;
+    }
+    if (filter != NULL && filter->counting) {
+        filter->lookups++;
+        filter->false_positives += val == NULL;
+    }
+    return val;
+}
+
+// returns the value contained by key after deleting node.  With tombstones on the node itself stays
+//      until trie_maintain gets to it
+void *
+trie_delete_key (radix_t *root_node, const char *key) {
+    radix_t *node;
+    void *val;
+
+    node = _trie_get_node(root_node, key);
+    if (node == NULL) {
+        return NULL;
+    }
+
+    if (RADIX_INFO(root_node)->tombstones) {
+        val = node->val;
+        node->val = NULL;
+        _trie_update_path_delta(node, val != NULL ? -1 : 0, RADIX_INFO(root_node));
+        if (node->parent != NULL) {
+            _trie_mark_dirty(RADIX_INFO(root_node), node);
+        }
+    } else {
+        val = _trie_delete_node(node, RADIX_INFO(root_node));
+    }
+    _trie_filter_deleted(root_node, val != NULL);
+
+    return val;
+}
+
+// returns the value that was found and key remainder
+void *
+trie_get_longest_match (radix_t *root_node, const char *key, char **full_match_remainder) {
+    char *remainder;
+    radix_t *full_match_node, *partial_match_node;
+    size_t len_match;
+
+    remainder = _trie_get_longest_match(root_node, key, &full_match_node,
+            &partial_match_node, &len_match);
+
+    *full_match_remainder = remainder;
+
+    // partial match was the same
+    if (partial_match_node == full_match_node) {
+        return full_match_node->val;
+    }
+
+    return NULL;
+}
+
+// returns how many nodes matching a given prefix were affected by a functionn pointer calback that
+// takes in the node's value.  Should have another function that calls this with no prefix in order
+// to apply callback to all nodes
+size_t
+trie_recurse_prefix (radix_t *root_node, const char *prefix, trie_value_callback callback) {
+    // get the longest partial match for prefix, use prefix as the root node
+
+    return 0;
 }
 
 size_t
@@ -652,6 +1821,459 @@ trie_recurse (radix_t *root_node, trie_value_callback callback) {
     return 0;
 }
 
+// merge every key of src into dst, grafting whole src subtrees wherever dst has nothing.  When both
+//      hold a key its value becomes resolve(dst_value, src_value), or src's value if resolve is NULL.
+//      src is left as an empty trie
+radix_t *
+trie_union (radix_t *dst_root, radix_t *src_root, trie_conflict_callback resolve) {
+    radix_info_t *info = RADIX_INFO(dst_root);
+
+    _trie_flush_dirty(dst_root);
+    _trie_flush_dirty(src_root);
+
+    // grafted subtrees keep what they have cached when both tries cache the same things
+    _trie_union_node(dst_root, src_root, resolve, info,
+            info->aggregate == RADIX_INFO(src_root)->aggregate &&
+            info->value_hash == RADIX_INFO(src_root)->value_hash);
+    _trie_update_node(src_root, RADIX_INFO(src_root));
+
+    // grafted subtrees never went through trie_set_key
+    if (_trie_get_filter(dst_root) != NULL) {
+        trie_rebuild_filter(dst_root);
+    }
+    if (_trie_get_filter(src_root) != NULL) {
+        trie_rebuild_filter(src_root);
+    }
+
+    return dst_root;
+}
+
+// remove every key from dst that is not in src, handing the removed values to discard (if any).
+//      Keys in both get the value resolve(dst_value, src_value), or keep dst's if resolve is NULL
+radix_t *
+trie_intersect (radix_t *dst_root, radix_t *src_root, trie_conflict_callback resolve,
+        trie_value_callback discard) {
+    size_t count = dst_root->count;
+
+    _trie_flush_dirty(dst_root);
+    _trie_intersect_node(dst_root, src_root, strlen(src_root->key), resolve, discard,
+            RADIX_INFO(dst_root));
+    _trie_filter_deleted(dst_root, count - dst_root->count);
+
+    return dst_root;
+}
+
+// remove every key in src from dst, handing the removed values to discard (if any)
+radix_t *
+trie_difference (radix_t *dst_root, radix_t *src_root, trie_value_callback discard) {
+    size_t count = dst_root->count;
+
+    _trie_flush_dirty(dst_root);
+    _trie_difference_node(dst_root, src_root, strlen(src_root->key), discard,
+            RADIX_INFO(dst_root));
+    _trie_filter_deleted(dst_root, count - dst_root->count);
+
+    return dst_root;
+}
+
+// unlink every key starting with prefix from the trie in one step and return them as a detached
+//      subtree (or NULL if there are none), to be freed later with trie_free_subtree, possibly from
+//      another thread
+radix_t *
+trie_detach_prefix (radix_t *root_node, const char *prefix) {
+    radix_t *node, *parent, *child;
+
+    _trie_flush_dirty(root_node);
+    node = _trie_get_prefix_node(root_node, prefix);
+    if (node == NULL || node->count == 0) {
+        return NULL;
+    }
+
+    if (node == root_node) {
+        // the root stays put, so hand its contents over to a new node instead
+        node = _trie_new_node("");
+        node->val = root_node->val;
+        node->child = root_node->child;
+        node->count = root_node->count;
+        node->agg = root_node->agg;
+        node->hash = root_node->hash;
+        for (child = node->child; child != NULL; child = child->right) {
+            child->parent = node;
+        }
+        root_node->val = NULL;
+        root_node->child = NULL;
+        _trie_update_path(root_node, RADIX_INFO(root_node));
+        _trie_filter_deleted(root_node, node->count);
+        return node;
+    }
+
+    parent = node->parent;
+    _trie_unlink_node(node);
+
+    // a branch node left with a single child gets folded into that child
+    if (parent->val == NULL) {
+        _trie_merge_node_with_child(parent);
+    }
+    _trie_update_path_delta(parent, -(long)node->count, RADIX_INFO(root_node));
+    _trie_filter_deleted(root_node, node->count);
+
+    return node;
+}
+
+// free a subtree returned by trie_detach_prefix
+void
+trie_free_subtree (radix_t *subtree, trie_value_callback value_destructor) {
+    _trie_free_subtree(subtree, value_destructor);
+}
+
+// delete every key starting with prefix, returns how many keys were deleted
+size_t
+trie_delete_prefix (radix_t *root_node, const char *prefix,
+        trie_value_callback value_destructor) {
+    radix_t *subtree = trie_detach_prefix(root_node, prefix);
+    size_t count;
+
+    if (subtree == NULL) {
+        return 0;
+    }
+
+    count = subtree->count;
+    _trie_free_subtree(subtree, value_destructor);
+
+    return count;
+}
+
+// defer the structural work of deletes: trie_delete_key only clears the value, and trie_maintain
+//      unlinks, merges and frees nodes later on
+void
+trie_enable_tombstones (radix_t *root_node) {
+    RADIX_INFO(root_node)->tombstones = 1;
+}
+
+void
+trie_disable_tombstones (radix_t *root_node) {
+    trie_maintain(root_node, 0);
+    RADIX_INFO(root_node)->tombstones = 0;
+}
+
+// restore path compression after tombstoned deletes, working through at most 'budget' nodes from the
+//      dirty list per call (0 means no limit).  Returns 1 once the trie is clean, 0 while there's
+//      more to do.  Union, intersection, difference, prefix deletes and diffs clean up first
+int
+trie_maintain (radix_t *root_node, size_t budget) {
+    radix_info_t *info = RADIX_INFO(root_node);
+    radix_t *node;
+    size_t done = 0;
+
+    while (info->dirty != NULL && (budget == 0 || done < budget)) {
+        node = info->dirty;
+        info->dirty = node->dirty != node ? node->dirty : NULL;
+        node->dirty = NULL;
+        _trie_maintain_node(info, node);
+        done++;
+    }
+
+    return info->dirty == NULL;
+}
+
+// keep a Merkle hash in every node from now on.  value_hash decides when two values are the same,
+//      trie_hash_pointer and trie_hash_string cover the common cases
+void
+trie_enable_hashing (radix_t *root_node, trie_hash_value_callback value_hash) {
+    RADIX_INFO(root_node)->value_hash = value_hash;
+    _trie_update_subtree(root_node, RADIX_INFO(root_node));
+}
+
+uint64_t
+trie_hash_pointer (void *value) {
+    return (uint64_t)(uintptr_t)value;
+}
+
+uint64_t
+trie_hash_string (void *value) {
+    return _trie_filter_hash(RADIX_FILTER_SEED, (const char *)value);
+}
+
+// call callback (if not NULL) for every key whose value differs between a and b, in key order, and
+//      return how many there were.  Values are the same when their pointers are, or when both tries
+//      hash values the same way and the hashes match; with hashing on, subtrees whose hashes match
+//      are skipped, so the cost follows the size of the difference rather than of the tries
+size_t
+trie_diff (radix_t *a, radix_t *b, trie_diff_callback callback) {
+    radix_diff_t diff;
+
+    diff.callback = callback;
+    diff.delta = NULL;
+    diff.encode = NULL;
+
+    return _trie_diff(a, b, &diff);
+}
+
+// returns a delta that turns a into b when applied with trie_apply_delta (and its length in *len),
+//      to be freed by the caller.  Values go through encode, or as raw pointers if it is NULL
+char *
+trie_delta (radix_t *a, radix_t *b, trie_value_encode_callback encode, size_t *len) {
+    radix_buf_t delta;
+    radix_diff_t diff;
+
+    memset(&delta, 0, sizeof(delta));
+    _trie_buf_append(&delta, NULL, 0);
+    diff.callback = NULL;
+    diff.delta = &delta;
+    diff.encode = encode;
+    _trie_diff(a, b, &diff);
+
+    *len = delta.len;
+    return delta.data;
+}
+
+// apply a delta from trie_delta, handing replaced and deleted values to discard (if any).  Values
+//      go through decode, or are read as raw pointers if it is NULL.  Returns how many keys were
+//      changed, or -1 if the delta is malformed (after applying what came before the problem)
+long
+trie_apply_delta (radix_t *root_node, const char *delta, size_t len,
+        trie_value_decode_callback decode, trie_value_callback discard) {
+    radix_buf_t key;
+    size_t pos = 0;
+    size_t shared, suffix_len, value_len, read;
+    long count = 0;
+    void *val, *old;
+
+    memset(&key, 0, sizeof(key));
+    _trie_buf_append(&key, NULL, 0);
+
+    while (pos < len) {
+        if ((read = _trie_get_varint(delta + pos, len - pos, &shared)) == 0 || shared > key.len) {
+            break;
+        }
+        pos += read;
+        if ((read = _trie_get_varint(delta + pos, len - pos, &suffix_len)) == 0 ||
+                suffix_len > len - pos - read) {
+            break;
+        }
+        pos += read;
+        _trie_buf_truncate(&key, shared);
+        _trie_buf_append(&key, delta + pos, suffix_len);
+        pos += suffix_len;
+
+        if ((read = _trie_get_varint(delta + pos, len - pos, &value_len)) == 0 ||
+                value_len > len - pos - read + 1 || (decode == NULL && value_len != 0 &&
+                value_len != sizeof(void *) + 1)) {
+            break;
+        }
+        pos += read;
+
+        if (value_len == 0) {
+            val = NULL;
+            old = trie_delete_key(root_node, key.data);
+        } else {
+            if (decode == NULL) {
+                memcpy(&val, delta + pos, sizeof(void *));
+            } else {
+                val = decode(delta + pos, value_len - 1);
+            }
+            pos += value_len - 1;
+            old = trie_get_key(root_node, key.data);
+            trie_set_key(root_node, key.data, val);
+        }
+        if (old != NULL && old != val && discard != NULL) {
+            discard(old);
+        }
+        count++;
+    }
+
+    free(key.data);
+    return pos == len ? count : -1;
+}
+
+// domain mode: host names (and rules like "*.example.com" or "ads.*.cdn.net") are stored with their
+//      labels reversed, so that everything under a domain shares a prefix.  Keys are reversed into
+//      a buffer on the stack, never allocated
+
+// returns the value that was set, or NULL if the host name is too long
+void *
+trie_set_domain (radix_t *root_node, const char *host, void *val) {
+    char key[RADIX_DOMAIN_MAX];
+
+    if (_trie_domain_key(host, key, sizeof(key)) < 0) {
+        return NULL;
+    }
+
+    return trie_set_key(root_node, key, val);
+}
+
+// returns the value stored for exactly this host (or rule), or NULL
+void *
+trie_get_domain (radix_t *root_node, const char *host) {
+    char key[RADIX_DOMAIN_MAX];
+
+    if (_trie_domain_key(host, key, sizeof(key)) < 0) {
+        return NULL;
+    }
+
+    return trie_get_key(root_node, key);
+}
+
+void *
+trie_delete_domain (radix_t *root_node, const char *host) {
+    char key[RADIX_DOMAIN_MAX];
+
+    if (_trie_domain_key(host, key, sizeof(key)) < 0) {
+        return NULL;
+    }
+
+    return trie_delete_key(root_node, key);
+}
+
+// returns the value of the longest stored domain that host is or is under ("example.com" matches
+//      "www.example.com" but not "badexample.com"), or NULL
+void *
+trie_match_suffix (radix_t *root_node, const char *host) {
+    return _trie_domain_match(root_node, host, 0);
+}
+
+// like trie_match_suffix, but a "*" label in a stored rule matches any one label of the host
+void *
+trie_match_domain (radix_t *root_node, const char *host) {
+    return _trie_domain_match(root_node, host, 1);
+}
+
+// trie_match_domain for a batch of hosts, results[i] gets the match for hosts[i].  Returns how
+//      many hosts matched
+size_t
+trie_match_domains (radix_t *root_node, const char **hosts, size_t num_hosts, void **results) {
+    size_t i, matched = 0;
+
+    for (i = 0; i < num_hosts; i++) {
+        results[i] = _trie_domain_match(root_node, hosts[i], 1);
+        if (results[i] != NULL) {
+            matched++;
+        }
+    }
+
+    return matched;
+}
+
+// returns how many keys start with prefix
+size_t
+trie_count_prefix (radix_t *root_node, const char *prefix) {
+    radix_t *node = _trie_get_prefix_node(root_node, prefix);
+
+    if (node == NULL) {
+        return 0;
+    }
+
+    return node->count;
+}
+
+// returns how many keys sort before key, whether or not key itself is in the trie
+size_t
+trie_rank (radix_t *root_node, const char *key) {
+    radix_t *node, *child;
+    const char *path = key;
+    size_t match_len;
+    size_t rank = 0;
+
+    node = root_node;
+    while (path[0] != 0) {
+        // this node's key is a proper prefix of the key, so it sorts first
+        if (node->val != NULL) {
+            rank++;
+        }
+
+        // siblings are ordered by their first byte, so everything before the branch we take is
+        //      smaller than the key
+        for (child = node->child; child != NULL && child->key[0] < path[0]; child = child->right) {
+            rank += child->count;
+        }
+        if (child == NULL || child->key[0] != path[0]) {
+            break;
+        }
+
+        match_len = _trie_string_cmp(child->key, path);
+        if (child->key[match_len] != 0) {
+            // the key diverges from (or ends inside) this node's key
+            if (path[match_len] != 0 && child->key[match_len] < path[match_len]) {
+                rank += child->count;
+            }
+            break;
+        }
+
+        path += match_len;
+        node = child;
+    }
+
+    return rank;
+}
+
+// returns the value of the key at (zero-based) position 'index' in key order, or NULL.  The key
+//      itself is copied into 'key' when it isn't NULL
+void *
+trie_select (radix_t *root_node, size_t index, char *key, size_t key_len) {
+    radix_t *node, *child;
+
+    if (key != NULL && key_len > 0) {
+        key[0] = 0;
+    }
+    if (index >= root_node->count) {
+        return NULL;
+    }
+
+    node = root_node;
+    while (node != NULL) {
+        if (node->val != NULL) {
+            if (index == 0) {
+                return node->val;
+            }
+            index--;
+        }
+
+        // skip whole subtrees until we find the one holding the index
+        for (child = node->child; child != NULL && index >= child->count; child = child->right) {
+            index -= child->count;
+        }
+        if (child != NULL && key != NULL) {
+            strlcat(key, child->key, key_len);
+        }
+        node = child;
+    }
+
+    return NULL;
+}
+
+// returns the aggregate of the values of every key starting with prefix
+radix_agg_t
+trie_aggregate_prefix (radix_t *root_node, const char *prefix) {
+    const radix_aggregate_t *aggregate = RADIX_INFO(root_node)->aggregate;
+    radix_t *node;
+
+    if (aggregate == NULL) {
+        return 0;
+    }
+
+    node = _trie_get_prefix_node(root_node, prefix);
+    if (node == NULL) {
+        return aggregate->identity;
+    }
+
+    return node->agg;
+}
+
+radix_agg_t
+trie_aggregate_sum (radix_agg_t a, radix_agg_t b) {
+    return a + b;
+}
+
+radix_agg_t
+trie_aggregate_min (radix_agg_t a, radix_agg_t b) {
+    return a < b ? a : b;
+}
+
+radix_agg_t
+trie_aggregate_max (radix_agg_t a, radix_agg_t b) {
+    return a > b ? a : b;
+}
+
 // STRING UTIL IMPLEMENTATIONS
 
 /* $OpenBSD: strlcpy.c,v 1.5 2001/05/13 15:40:16 deraadt Exp $ */
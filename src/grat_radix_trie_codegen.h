@@ -0,0 +1,238 @@
+/*
+ * Copyright (c) 2009, Elliot Foster (elliot dash source at grat dot net)
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 
+ * * Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ * 
+ * * Redistributions in binary form must reproduce the above
+ * copyright notice, this list of conditions and the following disclaimer
+ * in the documentation and/or other materials provided with the
+ * distribution.
+ * 
+ * * Neither the name of Gratuitous, Inc. nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * 
+ */
+
+#ifndef _GRAT_RADIX_TRIE_CODEGEN_H_
+#define _GRAT_RADIX_TRIE_CODEGEN_H_ 1
+
+#ifdef __cplusplus
+extern "C" {
+#endif // #ifdef __cplusplus
+
+#include <stdio.h>
+#include "grat_radix_trie.h"
+
+/*
+ *  Compile a fixed set of keys into C: trie_codegen writes out a matcher for the keys in a trie,
+ *      meant to be run at build time and the output included where the lookups happen.  Every node
+ *      becomes a switch on one byte at an offset known when generating, and the rest of its key a
+ *      few memcmps against literals of 8, 4, 2 or 1 bytes, which compilers turn into word compares.
+ *      There are no node structures left to chase, only code.
+ *
+ *  For a name of "http_method" the output defines
+ *
+ *      int http_method (const char *key, size_t len);
+ *          returns the ordinal of key (what trie_rank gives for it) or -1 if it isn't one
+ *      int http_method_prefix (const char *key, size_t len, size_t *match_len);
+ *          returns the ordinal of the longest key that key starts with (leaving its length in
+ *          *match_len) or -1
+ *
+ *  both static inline, and a comment listing the keys by ordinal.
+ */
+
+// PUBLIC METHOD DEFINITIONS/PROTOTYPES
+int trie_codegen (radix_t *root_node, const char *name, FILE *out);
+
+// PRIVATE METHODS
+
+void
+_trie_codegen_indent (FILE *out, int indent) {
+    fprintf(out, "%*s", indent * 4, "");
+}
+
+// a byte as a case label
+void
+_trie_codegen_case (FILE *out, unsigned char byte) {
+    if (byte >= 0x20 && byte < 0x7f && byte != '\'' && byte != '\\') {
+        fprintf(out, "case '%c':\n", byte);
+    } else {
+        fprintf(out, "case 0x%02x:\n", byte);
+    }
+}
+
+// 'len' bytes as a string literal, with octal escapes where needed
+void
+_trie_codegen_string (FILE *out, const char *bytes, size_t len) {
+    unsigned char byte;
+
+    fputc('"', out);
+    for (; len > 0; bytes++, len--) {
+        byte = (unsigned char)bytes[0];
+        if (byte >= 0x20 && byte < 0x7f && byte != '"' && byte != '\\' && byte != '?') {
+            fputc(byte, out);
+        } else {
+            fprintf(out, "\\%03o", byte);
+        }
+    }
+    fputc('"', out);
+}
+
+// compare the input at 'depth' against a label, in 8, 4, 2 and 1 byte pieces: compilers only turn
+//      a memcmp into a single load and compare when the size is one of those
+void
+_trie_codegen_compare (FILE *out, size_t depth, const char *label, int indent) {
+    size_t len = strlen(label);
+    size_t piece;
+
+    while (len > 0) {
+        for (piece = 8; piece > len; piece /= 2) {
+            continue;
+        }
+        fprintf(out, "memcmp(key + %lu, ", (unsigned long)depth);
+        _trie_codegen_string(out, label, piece);
+        fprintf(out, ", %lu) == 0", (unsigned long)piece);
+
+        depth += piece;
+        label += piece;
+        len -= piece;
+        if (len > 0) {
+            fprintf(out, " &&\n");
+            _trie_codegen_indent(out, indent);
+        }
+    }
+}
+
+// the statement(s) returning a match (or no match, when ordinal is -1)
+void
+_trie_codegen_return (FILE *out, int indent, int prefix, int ordinal, size_t len) {
+    if (prefix && ordinal >= 0) {
+        _trie_codegen_indent(out, indent);
+        fprintf(out, "*match_len = %lu;\n", (unsigned long)len);
+    }
+    _trie_codegen_indent(out, indent);
+    fprintf(out, "return %d;\n", ordinal);
+}
+
+// the code for a node whose key ends at 'depth' bytes into the input, once it has matched.  'best'
+//      and 'best_len' are the longest key matched on the way here, for prefix matchers
+void
+_trie_codegen_node (FILE *out, radix_t *node, size_t depth, int prefix, int *ordinal, int best,
+        size_t best_len, int indent) {
+    radix_t *child;
+    size_t len;
+
+    if (node->val != NULL) {
+        best = (*ordinal)++;
+        best_len = depth;
+    }
+
+    // which, for an exact matcher, is only a match if the input ends here too (and a leaf left
+    //      without a value, by a NULL set, is no match at all)
+    if (node->child == NULL) {
+        if (!prefix && node->val == NULL) {
+            _trie_codegen_indent(out, indent);
+            fprintf(out, "return -1;\n");
+        } else if (!prefix) {
+            _trie_codegen_indent(out, indent);
+            fprintf(out, "return len == %lu ? %d : -1;\n", (unsigned long)depth, best);
+        } else {
+            _trie_codegen_return(out, indent, prefix, best, best_len);
+        }
+        return;
+    }
+
+    _trie_codegen_indent(out, indent);
+    fprintf(out, "if (len == %lu) {\n", (unsigned long)depth);
+    _trie_codegen_return(out, indent + 1, prefix, prefix || node->val != NULL ? best : -1,
+            best_len);
+    _trie_codegen_indent(out, indent);
+    fprintf(out, "}\n");
+
+    _trie_codegen_indent(out, indent);
+    fprintf(out, "switch ((unsigned char)key[%lu]) {\n", (unsigned long)depth);
+    for (child = node->child; child != NULL; child = child->right) {
+        len = strlen(child->key);
+
+        _trie_codegen_indent(out, indent);
+        _trie_codegen_case(out, (unsigned char)child->key[0]);
+        if (len > 1) {
+            _trie_codegen_indent(out, indent + 1);
+            fprintf(out, "if (len >= %lu && ", (unsigned long)(depth + len));
+            _trie_codegen_compare(out, depth + 1, child->key + 1, indent + 3);
+            fprintf(out, ") {\n");
+            _trie_codegen_node(out, child, depth + len, prefix, ordinal, best, best_len,
+                    indent + 2);
+            _trie_codegen_indent(out, indent + 1);
+            fprintf(out, "}\n");
+            _trie_codegen_return(out, indent + 1, prefix, prefix ? best : -1, best_len);
+        } else {
+            _trie_codegen_node(out, child, depth + len, prefix, ordinal, best, best_len,
+                    indent + 1);
+        }
+    }
+    _trie_codegen_indent(out, indent);
+    fprintf(out, "}\n");
+    _trie_codegen_return(out, indent, prefix, prefix ? best : -1, best_len);
+}
+
+// PUBLIC METHOD IMPLEMENTATIONS
+
+// write C source for matchers over the keys in the trie to out, see above.  Finishes any pending
+//      trie_maintain work first.  Returns 0, or -1 if writing failed
+int
+trie_codegen (radix_t *root_node, const char *name, FILE *out) {
+    char key[1024];
+    size_t i;
+    int ordinal;
+
+    trie_maintain(root_node, 0);
+
+    fprintf(out, "// generated by trie_codegen from a trie of %lu keys, do not edit\n//\n",
+            (unsigned long)root_node->count);
+    for (i = 0; i < root_node->count; i++) {
+        trie_select(root_node, i, key, sizeof(key));
+        fprintf(out, "//  %3lu  ", (unsigned long)i);
+        _trie_codegen_string(out, key, strlen(key));
+        fputc('\n', out);
+    }
+    fprintf(out, "\n#include <stddef.h>\n#include <string.h>\n\n");
+
+    ordinal = 0;
+    fprintf(out, "static inline int\n%s (const char *key, size_t len) {\n", name);
+    _trie_codegen_node(out, root_node, 0, 0, &ordinal, -1, 0, 1);
+    fprintf(out, "}\n\n");
+
+    ordinal = 0;
+    fprintf(out, "static inline int\n%s_prefix (const char *key, size_t len, size_t *match_len) {\n",
+            name);
+    _trie_codegen_node(out, root_node, 0, 1, &ordinal, -1, 0, 1);
+    fprintf(out, "}\n");
+
+    return ferror(out) ? -1 : 0;
+}
+
+#ifdef __cplusplus
+} // extern "C"
+#endif // #ifdef __cplusplus
+
+#endif // #ifndef _GRAT_RADIX_TRIE_CODEGEN_H_
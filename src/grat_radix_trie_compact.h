@@ -0,0 +1,1361 @@
+/*
+ * Copyright (c) 2009, Elliot Foster (elliot dash source at grat dot net)
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 
+ * * Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ * 
+ * * Redistributions in binary form must reproduce the above
+ * copyright notice, this list of conditions and the following disclaimer
+ * in the documentation and/or other materials provided with the
+ * distribution.
+ * 
+ * * Neither the name of Gratuitous, Inc. nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * 
+ */
+
+#ifndef _GRAT_RADIX_TRIE_COMPACT_H_
+#define _GRAT_RADIX_TRIE_COMPACT_H_ 1
+
+#ifdef __cplusplus
+extern "C" {
+#endif // #ifdef __cplusplus
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ *  A compact radix trie: nodes live in one array of 32 byte slots and link to one another by 32 bit
+ *      indexes, with no parent or left sibling links (operations keep track of the path instead).
+ *      Labels of up to RADIX_COMPACT_INLINE bytes sit in the slot itself, longer ones live in a
+ *      shared label pool and keep their first bytes in the slot so that sibling scans and most
+ *      mismatches never leave the node's cache line.
+ *
+ *  Index 0 means "no node" and index 1 is always the root.
+ *
+ *  A hybrid trie (trie_compact_new_hybrid) keeps the keys below its leaves in burst buckets, as in
+ *      a HAT-trie: one contiguous, sorted block of (suffix, value) entries per leaf instead of a
+ *      chain of single-child nodes.  A bucket holding more than bucket_threshold keys bursts into a
+ *      node per first byte (each with a bucket of its own), and a node whose children are all
+ *      buckets holding at most half the threshold between them collapses back into one bucket.
+ *      A bucket leaf is marked by RADIX_COMPACT_BUCKET in 'child', with the bucket in 'val'.
+ */
+
+#define RADIX_COMPACT_INLINE 15
+// 'len' value marking a label stored in the label pool
+#define RADIX_COMPACT_EXTERNAL 0xff
+// bytes of an external label that are kept in the slot
+#define RADIX_COMPACT_PREFIX 7
+#define RADIX_COMPACT_ROOT 1
+#define RADIX_COMPACT_BUCKET ((radix_index_t)-1)
+// ancestors a delete tracks on the stack before moving its path to the heap
+#define RADIX_COMPACT_PATH 32
+
+typedef uint32_t radix_index_t;
+
+typedef struct {
+    radix_index_t child;
+    radix_index_t right;
+    void *val;
+    unsigned char len;
+    // inline: the label itself.  external: the first RADIX_COMPACT_PREFIX bytes, then the pool
+    //      offset and length of the whole label
+    char label[RADIX_COMPACT_INLINE];
+} radix_compact_node_t;
+
+// entries are packed back to back: a uint32_t suffix length, the suffix, then the value pointer
+typedef struct {
+    uint32_t count;
+    uint32_t used;
+    uint32_t size;
+    char entries[1];
+} radix_compact_bucket_t;
+
+// a node waiting to be copied by a relayout, the already copied slot that links to it and the node
+//      that slot is a copy of (whose link is checked again before copying, writes may have moved it)
+typedef struct {
+    radix_index_t index;
+    radix_index_t referrer;
+    radix_index_t owner;
+    int is_child;
+} radix_compact_ref_t;
+
+typedef struct {
+    radix_compact_node_t *nodes;
+    radix_index_t node_count;
+    radix_index_t node_capacity;
+    radix_index_t free_nodes;
+
+    char *labels;
+    uint32_t label_used;
+    uint32_t label_capacity;
+    uint32_t label_garbage;     // pool bytes no longer referenced by any node
+
+    size_t count;
+
+    // hybrid tries only, 0 otherwise
+    uint32_t bucket_threshold;
+    size_t bucket_bytes;
+
+    // relayout in progress, see trie_compact_relayout.  relayout_nodes is NULL when there is none
+    radix_compact_node_t *relayout_nodes;
+    radix_index_t relayout_count;
+    radix_index_t relayout_capacity;
+    radix_index_t relayout_free;            // copies of nodes freed since the relayout started
+    radix_index_t *relayout_map;            // where each node was copied to, 0 if not yet
+    char *relayout_labels;
+    uint32_t relayout_label_used;
+    uint32_t relayout_label_capacity;
+    uint32_t relayout_label_garbage;
+    radix_compact_ref_t *relayout_stack;
+    size_t relayout_depth;
+    size_t relayout_stack_size;
+} radix_compact_t;
+
+typedef void(*trie_compact_callback)(const char *key, void *value);
+
+#define RADIX_COMPACT_NODE(trie, index) (&(trie)->nodes[index])
+#define RADIX_COMPACT_IS_BUCKET(trie, index) (RADIX_COMPACT_NODE(trie, index)->child == \
+        RADIX_COMPACT_BUCKET)
+
+// PUBLIC METHOD DEFINITIONS/PROTOTYPES
+radix_compact_t * trie_compact_new ();
+radix_compact_t * trie_compact_new_hybrid (uint32_t bucket_threshold);
+void trie_compact_destroy (radix_compact_t *trie);
+void * trie_compact_set_key (radix_compact_t *trie, const char *key, void *val);
+void * trie_compact_get_key (radix_compact_t *trie, const char *key);
+void * trie_compact_delete_key (radix_compact_t *trie, const char *key);
+void * trie_compact_get_longest_match (radix_compact_t *trie, const char *key, char **remainder);
+size_t trie_compact_recurse (radix_compact_t *trie, trie_compact_callback callback);
+size_t trie_compact_memory (radix_compact_t *trie);
+int trie_compact_relayout (radix_compact_t *trie, size_t budget);
+
+// PRIVATE METHODS
+
+radix_index_t
+_trie_compact_alloc_node (radix_compact_t *trie) {
+    radix_compact_node_t *node;
+    radix_index_t index;
+
+    if (trie->free_nodes != 0) {
+        index = trie->free_nodes;
+        trie->free_nodes = RADIX_COMPACT_NODE(trie, index)->child;
+    } else {
+        if (trie->node_count == trie->node_capacity) {
+            trie->node_capacity *= 2;
+            trie->nodes = (radix_compact_node_t *)realloc(trie->nodes,
+                    trie->node_capacity * sizeof(radix_compact_node_t));
+            if (trie->relayout_nodes != NULL) {
+                trie->relayout_map = (radix_index_t *)realloc(trie->relayout_map,
+                        trie->node_capacity * sizeof(radix_index_t));
+                memset(trie->relayout_map + trie->node_count, 0,
+                        (trie->node_capacity - trie->node_count) * sizeof(radix_index_t));
+            }
+        }
+        index = trie->node_count++;
+    }
+
+    node = RADIX_COMPACT_NODE(trie, index);
+    memset(node, 0, sizeof(radix_compact_node_t));
+
+    return index;
+}
+
+void
+_trie_compact_free_node (radix_compact_t *trie, radix_index_t index) {
+    radix_compact_node_t *node = RADIX_COMPACT_NODE(trie, index);
+    radix_compact_node_t *copy;
+    uint32_t len;
+
+    if (node->len == RADIX_COMPACT_EXTERNAL) {
+        memcpy(&len, node->label + RADIX_COMPACT_PREFIX + sizeof(uint32_t), sizeof(uint32_t));
+        trie->label_garbage += len;
+    }
+
+    // a relayout in progress frees the node's copy too, it goes on the new layout's free list
+    if (trie->relayout_nodes != NULL && trie->relayout_map[index] != 0) {
+        copy = &trie->relayout_nodes[trie->relayout_map[index]];
+        if (copy->len == RADIX_COMPACT_EXTERNAL) {
+            memcpy(&len, copy->label + RADIX_COMPACT_PREFIX + sizeof(uint32_t), sizeof(uint32_t));
+            trie->relayout_label_garbage += len;
+        }
+        copy->len = 0;
+        copy->val = NULL;
+        copy->right = 0;
+        copy->child = trie->relayout_free;
+        trie->relayout_free = trie->relayout_map[index];
+        trie->relayout_map[index] = 0;
+    }
+
+    node->len = 0;
+    node->val = NULL;
+    node->right = 0;
+    node->child = trie->free_nodes;
+    trie->free_nodes = index;
+}
+
+// make room for len more bytes in the label pool.  This may move the pool
+void
+_trie_compact_reserve_labels (radix_compact_t *trie, uint32_t len) {
+    while (trie->label_used + len > trie->label_capacity) {
+        trie->label_capacity = trie->label_capacity ? trie->label_capacity * 2 : 256;
+        trie->labels = (char *)realloc(trie->labels, trie->label_capacity);
+    }
+}
+
+// returns a pointer to the node's label and its length by reference
+const char *
+_trie_compact_label (radix_compact_t *trie, radix_compact_node_t *node, uint32_t *len) {
+    uint32_t off;
+
+    if (node->len != RADIX_COMPACT_EXTERNAL) {
+        *len = node->len;
+        return node->label;
+    }
+
+    memcpy(&off, node->label + RADIX_COMPACT_PREFIX, sizeof(uint32_t));
+    memcpy(len, node->label + RADIX_COMPACT_PREFIX + sizeof(uint32_t), sizeof(uint32_t));
+    return trie->labels + off;
+}
+
+// point a node's label at bytes already in the label pool
+void
+_trie_compact_set_label_ref (radix_compact_t *trie, radix_compact_node_t *node, uint32_t off,
+        uint32_t len) {
+    if (len <= RADIX_COMPACT_INLINE) {
+        memcpy(node->label, trie->labels + off, len);
+        node->len = len;
+        return;
+    }
+
+    memcpy(node->label, trie->labels + off, RADIX_COMPACT_PREFIX);
+    memcpy(node->label + RADIX_COMPACT_PREFIX, &off, sizeof(uint32_t));
+    memcpy(node->label + RADIX_COMPACT_PREFIX + sizeof(uint32_t), &len, sizeof(uint32_t));
+    node->len = RADIX_COMPACT_EXTERNAL;
+}
+
+// copy a label into a node, spilling into the label pool if it doesn't fit in the slot.  'label'
+//      must not point into the pool
+void
+_trie_compact_set_label (radix_compact_t *trie, radix_index_t index, const char *label,
+        uint32_t len) {
+    radix_compact_node_t *node;
+    uint32_t off;
+
+    if (len <= RADIX_COMPACT_INLINE) {
+        node = RADIX_COMPACT_NODE(trie, index);
+        memcpy(node->label, label, len);
+        node->len = len;
+        return;
+    }
+
+    _trie_compact_reserve_labels(trie, len);
+    off = trie->label_used;
+    memcpy(trie->labels + off, label, len);
+    trie->label_used += len;
+    _trie_compact_set_label_ref(trie, RADIX_COMPACT_NODE(trie, index), off, len);
+}
+
+// returns the child of the node whose label starts with byte, or 0.  Sets *prev to the sibling in
+//      front of it (or 0 if it's the first child, or where a new child with that byte would go)
+radix_index_t
+_trie_compact_find_child (radix_compact_t *trie, radix_index_t index, char byte,
+        radix_index_t *prev) {
+    radix_compact_node_t *child;
+    radix_index_t child_index = RADIX_COMPACT_NODE(trie, index)->child;
+
+    *prev = 0;
+    while (child_index != 0) {
+        child = RADIX_COMPACT_NODE(trie, child_index);
+        if (child->label[0] == byte) {
+            return child_index;
+        }
+        if (child->label[0] > byte) {
+            break;
+        }
+        *prev = child_index;
+        child_index = child->right;
+    }
+
+    return 0;
+}
+
+// returns how many bytes of the label match the start of key
+uint32_t
+_trie_compact_match (const char *label, uint32_t len, const char *key) {
+    uint32_t bytes = 0;
+
+    while (bytes < len && key[bytes] != '\0' && label[bytes] == key[bytes]) {
+        bytes++;
+    }
+
+    return bytes;
+}
+
+// link a new child in after prev (or first if prev is 0)
+void
+_trie_compact_link_child (radix_compact_t *trie, radix_index_t parent, radix_index_t prev,
+        radix_index_t child) {
+    if (prev == 0) {
+        RADIX_COMPACT_NODE(trie, child)->right = RADIX_COMPACT_NODE(trie, parent)->child;
+        RADIX_COMPACT_NODE(trie, parent)->child = child;
+    } else {
+        RADIX_COMPACT_NODE(trie, child)->right = RADIX_COMPACT_NODE(trie, prev)->right;
+        RADIX_COMPACT_NODE(trie, prev)->right = child;
+    }
+}
+
+// split a node so its label is the first len bytes, with the rest moved to a new only child
+void
+_trie_compact_split_node (radix_compact_t *trie, radix_index_t index, uint32_t len) {
+    radix_compact_node_t *node, *tail;
+    radix_index_t tail_index;
+    uint32_t off, label_len;
+    char label[RADIX_COMPACT_INLINE];
+
+    tail_index = _trie_compact_alloc_node(trie);
+    node = RADIX_COMPACT_NODE(trie, index);
+    tail = RADIX_COMPACT_NODE(trie, tail_index);
+
+    if (node->len == RADIX_COMPACT_EXTERNAL) {
+        // both halves keep pointing into the same pool bytes
+        memcpy(&off, node->label + RADIX_COMPACT_PREFIX, sizeof(uint32_t));
+        memcpy(&label_len, node->label + RADIX_COMPACT_PREFIX + sizeof(uint32_t),
+                sizeof(uint32_t));
+        _trie_compact_set_label_ref(trie, tail, off + len, label_len - len);
+        _trie_compact_set_label_ref(trie, node, off, len);
+    } else {
+        memcpy(label, node->label, node->len);
+        memcpy(tail->label, label + len, node->len - len);
+        tail->len = node->len - len;
+        node->len = len;
+    }
+
+    tail->val = node->val;
+    tail->child = node->child;
+    node->val = NULL;
+    node->child = tail_index;
+}
+
+// fold a valueless non-root node into its only child
+void
+_trie_compact_merge_node_with_child (radix_compact_t *trie, radix_index_t index) {
+    radix_compact_node_t *node, *child;
+    radix_index_t child_index;
+    uint32_t len, child_len, off, child_off;
+    const char *label, *child_label;
+    char merged[RADIX_COMPACT_INLINE];
+
+    node = RADIX_COMPACT_NODE(trie, index);
+    child_index = node->child;
+    if (index == RADIX_COMPACT_ROOT || node->val != NULL || child_index == 0 ||
+            RADIX_COMPACT_NODE(trie, child_index)->right != 0) {
+        return;
+    }
+    child = RADIX_COMPACT_NODE(trie, child_index);
+
+    label = _trie_compact_label(trie, node, &len);
+    child_label = _trie_compact_label(trie, child, &child_len);
+
+    if (node->len == RADIX_COMPACT_EXTERNAL && child->len == RADIX_COMPACT_EXTERNAL &&
+            label + len == child_label) {
+        // a node split earlier and now joined again, the pool bytes are still contiguous
+        off = label - trie->labels;
+        _trie_compact_set_label_ref(trie, node, off, len + child_len);
+    } else if (len + child_len <= RADIX_COMPACT_INLINE) {
+        memcpy(merged, label, len);
+        memcpy(merged + len, child_label, child_len);
+        memcpy(node->label, merged, len + child_len);
+        node->len = len + child_len;
+    } else {
+        // copy both halves to the end of the pool, minding that reserving can move the pool
+        off = node->len == RADIX_COMPACT_EXTERNAL ? (uint32_t)(label - trie->labels) : 0;
+        child_off = child->len == RADIX_COMPACT_EXTERNAL ?
+            (uint32_t)(child_label - trie->labels) : 0;
+        _trie_compact_reserve_labels(trie, len + child_len);
+        if (node->len == RADIX_COMPACT_EXTERNAL) {
+            trie->label_garbage += len;
+            label = trie->labels + off;
+        }
+        if (child->len == RADIX_COMPACT_EXTERNAL) {
+            trie->label_garbage += child_len;
+            child_label = trie->labels + child_off;
+        }
+        memcpy(trie->labels + trie->label_used, label, len);
+        memcpy(trie->labels + trie->label_used + len, child_label, child_len);
+        _trie_compact_set_label_ref(trie, node, trie->label_used, len + child_len);
+        trie->label_used += len + child_len;
+    }
+
+    node->val = child->val;
+    node->child = child->child;
+    // the child's label bytes now belong to the merged node, don't count them as garbage
+    child->len = 0;
+    _trie_compact_free_node(trie, child_index);
+}
+
+// compare two byte strings in trie order (shorter first when one is a prefix of the other)
+int
+_trie_compact_key_cmp (const char *a, uint32_t a_len, const char *b, uint32_t b_len) {
+    uint32_t i;
+
+    for (i = 0; i < a_len && i < b_len; i++) {
+        if (a[i] != b[i]) {
+            return a[i] < b[i] ? -1 : 1;
+        }
+    }
+
+    return a_len < b_len ? -1 : a_len > b_len;
+}
+
+uint32_t
+_trie_compact_entry_len (radix_compact_bucket_t *bucket, uint32_t off) {
+    uint32_t len;
+
+    memcpy(&len, bucket->entries + off, sizeof(uint32_t));
+    return len;
+}
+
+const char *
+_trie_compact_entry_key (radix_compact_bucket_t *bucket, uint32_t off) {
+    return bucket->entries + off + sizeof(uint32_t);
+}
+
+void *
+_trie_compact_entry_val (radix_compact_bucket_t *bucket, uint32_t off) {
+    void *val;
+
+    memcpy(&val, bucket->entries + off + sizeof(uint32_t) + _trie_compact_entry_len(bucket, off),
+            sizeof(void *));
+    return val;
+}
+
+uint32_t
+_trie_compact_entry_next (radix_compact_bucket_t *bucket, uint32_t off) {
+    return off + sizeof(uint32_t) + _trie_compact_entry_len(bucket, off) + sizeof(void *);
+}
+
+radix_compact_bucket_t *
+_trie_compact_new_bucket (radix_compact_t *trie) {
+    radix_compact_bucket_t *bucket;
+    uint32_t size = 64;
+
+    bucket = (radix_compact_bucket_t *)malloc(sizeof(radix_compact_bucket_t) + size);
+    bucket->count = 0;
+    bucket->used = 0;
+    bucket->size = size;
+    trie->bucket_bytes += sizeof(radix_compact_bucket_t) + size;
+
+    return bucket;
+}
+
+void
+_trie_compact_free_bucket (radix_compact_t *trie, radix_compact_bucket_t *bucket) {
+    trie->bucket_bytes -= sizeof(radix_compact_bucket_t) + bucket->size;
+    free(bucket);
+}
+
+// returns the offset of the entry for key, or of where it would go, and whether it was there
+uint32_t
+_trie_compact_bucket_find (radix_compact_bucket_t *bucket, const char *key, uint32_t len,
+        int *found) {
+    uint32_t off = 0;
+    int cmp;
+
+    *found = 0;
+    while (off < bucket->used) {
+        cmp = _trie_compact_key_cmp(_trie_compact_entry_key(bucket, off),
+                _trie_compact_entry_len(bucket, off), key, len);
+        if (cmp >= 0) {
+            *found = cmp == 0;
+            break;
+        }
+        off = _trie_compact_entry_next(bucket, off);
+    }
+
+    return off;
+}
+
+// insert an entry made of prefix + suffix at off.  The bucket may move
+radix_compact_bucket_t *
+_trie_compact_bucket_insert (radix_compact_t *trie, radix_compact_bucket_t *bucket, uint32_t off,
+        const char *prefix, uint32_t prefix_len, const char *suffix, uint32_t suffix_len,
+        void *val) {
+    uint32_t len = prefix_len + suffix_len;
+    uint32_t entry_len = sizeof(uint32_t) + len + sizeof(void *);
+    char *entry;
+
+    if (bucket->used + entry_len > bucket->size) {
+        trie->bucket_bytes -= bucket->size;
+        while (bucket->used + entry_len > bucket->size) {
+            bucket->size *= 2;
+        }
+        trie->bucket_bytes += bucket->size;
+        bucket = (radix_compact_bucket_t *)realloc(bucket,
+                sizeof(radix_compact_bucket_t) + bucket->size);
+    }
+
+    entry = bucket->entries + off;
+    memmove(entry + entry_len, entry, bucket->used - off);
+    memcpy(entry, &len, sizeof(uint32_t));
+    if (prefix_len > 0) {
+        memcpy(entry + sizeof(uint32_t), prefix, prefix_len);
+    }
+    if (suffix_len > 0) {
+        memcpy(entry + sizeof(uint32_t) + prefix_len, suffix, suffix_len);
+    }
+    memcpy(entry + sizeof(uint32_t) + len, &val, sizeof(void *));
+    bucket->used += entry_len;
+    bucket->count++;
+
+    return bucket;
+}
+
+void
+_trie_compact_bucket_remove (radix_compact_bucket_t *bucket, uint32_t off) {
+    uint32_t next = _trie_compact_entry_next(bucket, off);
+
+    memmove(bucket->entries + off, bucket->entries + next, bucket->used - next);
+    bucket->used -= next - off;
+    bucket->count--;
+}
+
+// turn a node into a bucket leaf holding the given bucket
+void
+_trie_compact_set_bucket (radix_compact_t *trie, radix_index_t index,
+        radix_compact_bucket_t *bucket) {
+    RADIX_COMPACT_NODE(trie, index)->child = RADIX_COMPACT_BUCKET;
+    RADIX_COMPACT_NODE(trie, index)->val = bucket;
+}
+
+// a new child for the rest of a key: a plain leaf, or in a hybrid trie a one byte node with a
+//      bucket for everything after that byte
+radix_index_t
+_trie_compact_new_leaf (radix_compact_t *trie, const char *key, void *val) {
+    radix_compact_bucket_t *bucket;
+    radix_index_t leaf = _trie_compact_alloc_node(trie);
+
+    if (trie->bucket_threshold == 0) {
+        _trie_compact_set_label(trie, leaf, key, strlen(key));
+        RADIX_COMPACT_NODE(trie, leaf)->val = val;
+    } else {
+        _trie_compact_set_label(trie, leaf, key, 1);
+        bucket = _trie_compact_new_bucket(trie);
+        bucket = _trie_compact_bucket_insert(trie, bucket, 0, NULL, 0, key + 1, strlen(key + 1),
+                val);
+        _trie_compact_set_bucket(trie, leaf, bucket);
+    }
+    if (val != NULL) {
+        trie->count++;
+    }
+
+    return leaf;
+}
+
+// split an overfull bucket leaf into a node with one child per distinct first byte
+void
+_trie_compact_burst (radix_compact_t *trie, radix_index_t index) {
+    radix_compact_bucket_t *bucket, *child_bucket;
+    radix_index_t child, prev;
+    uint32_t off, start, end, prefix_len, match_len;
+    const char *first;
+
+    bucket = (radix_compact_bucket_t *)RADIX_COMPACT_NODE(trie, index)->val;
+    RADIX_COMPACT_NODE(trie, index)->val = NULL;
+    RADIX_COMPACT_NODE(trie, index)->child = 0;
+
+    off = 0;
+    if (bucket->used > 0 && _trie_compact_entry_len(bucket, 0) == 0) {
+        // the key ending right at this node
+        RADIX_COMPACT_NODE(trie, index)->val = _trie_compact_entry_val(bucket, 0);
+        off = _trie_compact_entry_next(bucket, 0);
+    }
+
+    prev = 0;
+    while (off < bucket->used) {
+        // entries are sorted, so everything sharing a first byte is together.  The new node takes
+        //      the longest prefix that whole group shares
+        start = off;
+        first = _trie_compact_entry_key(bucket, start);
+        prefix_len = _trie_compact_entry_len(bucket, start);
+        for (end = start; end < bucket->used && _trie_compact_entry_key(bucket, end)[0] == first[0];
+                end = _trie_compact_entry_next(bucket, end)) {
+            match_len = 0;
+            while (match_len < prefix_len && match_len < _trie_compact_entry_len(bucket, end) &&
+                    _trie_compact_entry_key(bucket, end)[match_len] == first[match_len]) {
+                match_len++;
+            }
+            prefix_len = match_len;
+        }
+
+        child_bucket = _trie_compact_new_bucket(trie);
+        for (off = start; off < end; off = _trie_compact_entry_next(bucket, off)) {
+            child_bucket = _trie_compact_bucket_insert(trie, child_bucket, child_bucket->used,
+                    NULL, 0, _trie_compact_entry_key(bucket, off) + prefix_len,
+                    _trie_compact_entry_len(bucket, off) - prefix_len,
+                    _trie_compact_entry_val(bucket, off));
+        }
+
+        child = _trie_compact_alloc_node(trie);
+        _trie_compact_set_label(trie, child, first, prefix_len);
+        _trie_compact_set_bucket(trie, child, child_bucket);
+        _trie_compact_link_child(trie, index, prev, child);
+        prev = child;
+
+        if (child_bucket->count > trie->bucket_threshold) {
+            _trie_compact_burst(trie, child);
+        }
+    }
+
+    _trie_compact_free_bucket(trie, bucket);
+}
+
+// fold a node whose children are all small bucket leaves back into a single bucket leaf
+void
+_trie_compact_collapse (radix_compact_t *trie, radix_index_t index) {
+    radix_compact_bucket_t *bucket, *child_bucket;
+    radix_index_t child, next;
+    const char *label;
+    uint32_t total, len, off;
+
+    if (trie->bucket_threshold == 0 || RADIX_COMPACT_IS_BUCKET(trie, index)) {
+        return;
+    }
+
+    total = RADIX_COMPACT_NODE(trie, index)->val != NULL ? 1 : 0;
+    for (child = RADIX_COMPACT_NODE(trie, index)->child; child != 0;
+            child = RADIX_COMPACT_NODE(trie, child)->right) {
+        if (!RADIX_COMPACT_IS_BUCKET(trie, child)) {
+            return;
+        }
+        total += ((radix_compact_bucket_t *)RADIX_COMPACT_NODE(trie, child)->val)->count;
+    }
+    if (total > trie->bucket_threshold / 2) {
+        return;
+    }
+
+    bucket = _trie_compact_new_bucket(trie);
+    if (RADIX_COMPACT_NODE(trie, index)->val != NULL) {
+        bucket = _trie_compact_bucket_insert(trie, bucket, 0, NULL, 0, NULL, 0,
+                RADIX_COMPACT_NODE(trie, index)->val);
+    }
+
+    // children and their entries are both in order, so appending keeps the bucket sorted
+    for (child = RADIX_COMPACT_NODE(trie, index)->child; child != 0; child = next) {
+        next = RADIX_COMPACT_NODE(trie, child)->right;
+        label = _trie_compact_label(trie, RADIX_COMPACT_NODE(trie, child), &len);
+        child_bucket = (radix_compact_bucket_t *)RADIX_COMPACT_NODE(trie, child)->val;
+
+        for (off = 0; off < child_bucket->used; off = _trie_compact_entry_next(child_bucket, off)) {
+            bucket = _trie_compact_bucket_insert(trie, bucket, bucket->used, label, len,
+                    _trie_compact_entry_key(child_bucket, off),
+                    _trie_compact_entry_len(child_bucket, off),
+                    _trie_compact_entry_val(child_bucket, off));
+        }
+
+        _trie_compact_free_bucket(trie, child_bucket);
+        _trie_compact_free_node(trie, child);
+    }
+
+    _trie_compact_set_bucket(trie, index, bucket);
+}
+
+// collapse the innermost ancestor on the path and keep going up for as long as each one turns into a
+//      bucket, since that can leave its own parent with nothing but small buckets below it
+void
+_trie_compact_collapse_path (radix_compact_t *trie, radix_index_t *path, size_t depth) {
+    while (depth > 0) {
+        depth--;
+        _trie_compact_collapse(trie, path[depth]);
+        if (!RADIX_COMPACT_IS_BUCKET(trie, path[depth])) {
+            break;
+        }
+    }
+}
+
+// append to a path that starts out in a caller's stack buffer and moves to the heap if it outgrows it
+radix_index_t *
+_trie_compact_push_path (radix_index_t *path, radix_index_t *path_buf, size_t *path_size,
+        size_t depth, radix_index_t index) {
+    if (depth == *path_size) {
+        *path_size *= 2;
+        if (path == path_buf) {
+            path = (radix_index_t *)malloc(*path_size * sizeof(radix_index_t));
+            memcpy(path, path_buf, depth * sizeof(radix_index_t));
+        } else {
+            path = (radix_index_t *)realloc(path, *path_size * sizeof(radix_index_t));
+        }
+    }
+    path[depth] = index;
+    return path;
+}
+
+// returns the node holding exactly key or, in a hybrid trie, the bucket leaf the rest of the key
+//      would be in (with that rest returned by reference).  Returns 0 if there's no such node
+radix_index_t
+_trie_compact_get_node (radix_compact_t *trie, const char *key, const char **remainder) {
+    radix_index_t index, prev;
+    const char *label;
+    uint32_t len;
+
+    index = RADIX_COMPACT_ROOT;
+    while (key[0] != 0 && !RADIX_COMPACT_IS_BUCKET(trie, index)) {
+        index = _trie_compact_find_child(trie, index, key[0], &prev);
+        if (index == 0) {
+            return 0;
+        }
+
+        label = _trie_compact_label(trie, RADIX_COMPACT_NODE(trie, index), &len);
+        if (strncmp(label, key, len) != 0) {
+            return 0;
+        }
+        key += len;
+    }
+
+    *remainder = key;
+    return index;
+}
+
+typedef struct {
+    char *key;
+    size_t len;
+    size_t size;
+} radix_compact_key_t;
+
+size_t
+_trie_compact_recurse (radix_compact_t *trie, radix_index_t index, radix_compact_key_t *key,
+        trie_compact_callback callback) {
+    radix_compact_node_t *node = RADIX_COMPACT_NODE(trie, index);
+    radix_compact_bucket_t *bucket;
+    radix_index_t child;
+    const char *label;
+    size_t key_len = key->len;
+    size_t found = 0;
+    uint32_t len, off;
+
+    label = _trie_compact_label(trie, node, &len);
+    if (key->len + len + 1 > key->size) {
+        key->size = (key->len + len + 1) * 2;
+        key->key = (char *)realloc(key->key, key->size);
+    }
+    memcpy(key->key + key->len, label, len);
+    key->len += len;
+    key->key[key->len] = 0;
+
+    if (node->child == RADIX_COMPACT_BUCKET) {
+        bucket = (radix_compact_bucket_t *)node->val;
+        for (off = 0; off < bucket->used; off = _trie_compact_entry_next(bucket, off)) {
+            len = _trie_compact_entry_len(bucket, off);
+            if (key->len + len + 1 > key->size) {
+                key->size = (key->len + len + 1) * 2;
+                key->key = (char *)realloc(key->key, key->size);
+            }
+            memcpy(key->key + key->len, _trie_compact_entry_key(bucket, off), len);
+            key->key[key->len + len] = 0;
+            found++;
+            callback(key->key, _trie_compact_entry_val(bucket, off));
+        }
+        key->len = key_len;
+        return found;
+    }
+
+    if (node->val != NULL) {
+        found++;
+        callback(key->key, node->val);
+    }
+    for (child = node->child; child != 0; child = RADIX_COMPACT_NODE(trie, child)->right) {
+        found += _trie_compact_recurse(trie, child, key, callback);
+    }
+
+    key->len = key_len;
+    return found;
+}
+
+// throw away a relayout in progress, the trie itself is untouched until a relayout finishes
+void
+_trie_compact_abort_relayout (radix_compact_t *trie) {
+    if (trie->relayout_nodes == NULL) {
+        return;
+    }
+
+    free(trie->relayout_nodes);
+    free(trie->relayout_map);
+    free(trie->relayout_labels);
+    free(trie->relayout_stack);
+    trie->relayout_nodes = NULL;
+    trie->relayout_map = NULL;
+    trie->relayout_labels = NULL;
+    trie->relayout_stack = NULL;
+}
+
+void
+_trie_compact_push_relayout (radix_compact_t *trie, radix_index_t index, radix_index_t referrer,
+        radix_index_t owner, int is_child) {
+    radix_compact_ref_t *ref;
+
+    if (trie->relayout_depth == trie->relayout_stack_size) {
+        trie->relayout_stack_size *= 2;
+        trie->relayout_stack = (radix_compact_ref_t *)realloc(trie->relayout_stack,
+                trie->relayout_stack_size * sizeof(radix_compact_ref_t));
+    }
+
+    ref = &trie->relayout_stack[trie->relayout_depth++];
+    ref->index = index;
+    ref->referrer = referrer;
+    ref->owner = owner;
+    ref->is_child = is_child;
+}
+
+void
+_trie_compact_start_relayout (radix_compact_t *trie) {
+    trie->relayout_capacity = trie->node_count;
+    trie->relayout_nodes = (radix_compact_node_t *)malloc(trie->relayout_capacity *
+            sizeof(radix_compact_node_t));
+    memset(trie->relayout_nodes, 0, sizeof(radix_compact_node_t));
+    trie->relayout_count = 1;
+    trie->relayout_free = 0;
+    trie->relayout_map = (radix_index_t *)calloc(trie->node_capacity, sizeof(radix_index_t));
+
+    // without writes in between this is exactly what's needed, writes grow it as they go
+    trie->relayout_label_capacity = trie->label_used - trie->label_garbage;
+    trie->relayout_labels = (char *)malloc(trie->relayout_label_capacity + 1);
+    trie->relayout_label_used = 0;
+    trie->relayout_label_garbage = 0;
+
+    trie->relayout_stack_size = 64;
+    trie->relayout_stack = (radix_compact_ref_t *)malloc(trie->relayout_stack_size *
+            sizeof(radix_compact_ref_t));
+    trie->relayout_depth = 0;
+    _trie_compact_push_relayout(trie, RADIX_COMPACT_ROOT, 0, 0, 0);
+}
+
+// returns what a copy should link to for a link to index: its copy if it has one, otherwise 0 with
+//      index queued to be copied and linked in later
+radix_index_t
+_trie_compact_relayout_link (radix_compact_t *trie, radix_index_t index, radix_index_t referrer,
+        radix_index_t owner, int is_child) {
+    if (index == 0 || index == RADIX_COMPACT_BUCKET) {
+        return index;
+    }
+    if (trie->relayout_map[index] != 0) {
+        return trie->relayout_map[index];
+    }
+
+    _trie_compact_push_relayout(trie, index, referrer, owner, is_child);
+    return 0;
+}
+
+// make the copy of a node match the node, including its label and links
+void
+_trie_compact_relayout_fill (radix_compact_t *trie, radix_index_t index) {
+    radix_compact_node_t *node = RADIX_COMPACT_NODE(trie, index);
+    radix_index_t copy_index = trie->relayout_map[index];
+    radix_compact_node_t *copy = &trie->relayout_nodes[copy_index];
+    const char *label;
+    uint32_t len, off;
+
+    memcpy(copy, node, sizeof(radix_compact_node_t));
+
+    if (node->len == RADIX_COMPACT_EXTERNAL) {
+        // keys get laid out in the same order as the nodes that use them
+        label = _trie_compact_label(trie, node, &len);
+        while (trie->relayout_label_used + len > trie->relayout_label_capacity) {
+            trie->relayout_label_capacity = trie->relayout_label_capacity ?
+                trie->relayout_label_capacity * 2 : 256;
+            trie->relayout_labels = (char *)realloc(trie->relayout_labels,
+                    trie->relayout_label_capacity + 1);
+        }
+        off = trie->relayout_label_used;
+        memcpy(trie->relayout_labels + off, label, len);
+        trie->relayout_label_used += len;
+        memcpy(copy->label + RADIX_COMPACT_PREFIX, &off, sizeof(uint32_t));
+    }
+
+    // the right sibling goes on the stack first so the whole subtree is copied before it
+    copy->right = _trie_compact_relayout_link(trie, node->right, copy_index, index, 0);
+    copy->child = _trie_compact_relayout_link(trie, node->child, copy_index, index, 1);
+}
+
+// copy the next node in depth first order to the end of the new layout
+void
+_trie_compact_relayout_node (radix_compact_t *trie) {
+    radix_compact_ref_t ref = trie->relayout_stack[--trie->relayout_depth];
+    radix_index_t link;
+
+    if (ref.referrer != 0) {
+        // skip it if a write has since unlinked it from the node that queued it
+        link = ref.is_child ? RADIX_COMPACT_NODE(trie, ref.owner)->child :
+            RADIX_COMPACT_NODE(trie, ref.owner)->right;
+        if (trie->relayout_map[ref.owner] != ref.referrer || link != ref.index) {
+            return;
+        }
+    }
+
+    if (trie->relayout_map[ref.index] == 0) {
+        if (trie->relayout_count == trie->relayout_capacity) {
+            trie->relayout_capacity *= 2;
+            trie->relayout_nodes = (radix_compact_node_t *)realloc(trie->relayout_nodes,
+                    trie->relayout_capacity * sizeof(radix_compact_node_t));
+        }
+        trie->relayout_map[ref.index] = trie->relayout_count++;
+        _trie_compact_relayout_fill(trie, ref.index);
+    }
+
+    if (ref.referrer != 0) {
+        if (ref.is_child) {
+            trie->relayout_nodes[ref.referrer].child = trie->relayout_map[ref.index];
+        } else {
+            trie->relayout_nodes[ref.referrer].right = trie->relayout_map[ref.index];
+        }
+    }
+}
+
+// fill the copy of a node again after a write changed the node, if it has been copied yet
+void
+_trie_compact_relayout_refill (radix_compact_t *trie, radix_index_t index) {
+    radix_compact_node_t *copy;
+    uint32_t len;
+
+    if (trie->relayout_map[index] == 0) {
+        return;
+    }
+
+    copy = &trie->relayout_nodes[trie->relayout_map[index]];
+    if (copy->len == RADIX_COMPACT_EXTERNAL) {
+        memcpy(&len, copy->label + RADIX_COMPACT_PREFIX + sizeof(uint32_t), sizeof(uint32_t));
+        trie->relayout_label_garbage += len;
+    }
+    _trie_compact_relayout_fill(trie, index);
+}
+
+// bring the copies of the nodes a write along key may have changed up to date.  Writes only touch
+//      nodes on the key's path and their children, so this costs about what the write did
+void
+_trie_compact_relayout_path (radix_compact_t *trie, const char *key) {
+    radix_index_t index, child, prev;
+    const char *label;
+    uint32_t len;
+
+    index = RADIX_COMPACT_ROOT;
+    _trie_compact_relayout_refill(trie, index);
+    while (!RADIX_COMPACT_IS_BUCKET(trie, index)) {
+        for (child = RADIX_COMPACT_NODE(trie, index)->child; child != 0;
+                child = RADIX_COMPACT_NODE(trie, child)->right) {
+            _trie_compact_relayout_refill(trie, child);
+        }
+
+        if (key[0] == 0) {
+            break;
+        }
+        index = _trie_compact_find_child(trie, index, key[0], &prev);
+        if (index == 0) {
+            break;
+        }
+        label = _trie_compact_label(trie, RADIX_COMPACT_NODE(trie, index), &len);
+        if (strncmp(label, key, len) != 0) {
+            break;
+        }
+        key += len;
+    }
+}
+
+void
+_trie_compact_finish_relayout (radix_compact_t *trie) {
+    free(trie->nodes);
+    free(trie->labels);
+
+    trie->nodes = trie->relayout_nodes;
+    trie->node_count = trie->relayout_count;
+    trie->node_capacity = trie->relayout_capacity;
+    trie->free_nodes = trie->relayout_free;
+
+    trie->labels = trie->relayout_labels;
+    trie->label_used = trie->relayout_label_used;
+    trie->label_capacity = trie->relayout_label_capacity;
+    trie->label_garbage = trie->relayout_label_garbage;
+
+    free(trie->relayout_map);
+    free(trie->relayout_stack);
+    trie->relayout_nodes = NULL;
+    trie->relayout_map = NULL;
+    trie->relayout_labels = NULL;
+    trie->relayout_stack = NULL;
+}
+
+// PUBLIC METHOD IMPLEMENTATIONS
+
+radix_compact_t *
+trie_compact_new () {
+    radix_compact_t *trie = (radix_compact_t *)malloc(sizeof(radix_compact_t));
+
+    trie->node_capacity = 64;
+    trie->nodes = (radix_compact_node_t *)malloc(trie->node_capacity *
+            sizeof(radix_compact_node_t));
+    // slot 0 is "no node", slot 1 is the root
+    memset(trie->nodes, 0, 2 * sizeof(radix_compact_node_t));
+    trie->node_count = 2;
+    trie->free_nodes = 0;
+
+    trie->labels = NULL;
+    trie->label_used = 0;
+    trie->label_capacity = 0;
+    trie->label_garbage = 0;
+
+    trie->count = 0;
+
+    trie->bucket_threshold = 0;
+    trie->bucket_bytes = 0;
+
+    trie->relayout_nodes = NULL;
+    trie->relayout_map = NULL;
+    trie->relayout_labels = NULL;
+    trie->relayout_stack = NULL;
+
+    return trie;
+}
+
+// get a new hybrid trie whose leaves hold up to bucket_threshold keys each in a burst bucket
+radix_compact_t *
+trie_compact_new_hybrid (uint32_t bucket_threshold) {
+    radix_compact_t *trie = trie_compact_new();
+
+    trie->bucket_threshold = bucket_threshold > 0 ? bucket_threshold : 1;
+    _trie_compact_set_bucket(trie, RADIX_COMPACT_ROOT, _trie_compact_new_bucket(trie));
+
+    return trie;
+}
+
+void
+trie_compact_destroy (radix_compact_t *trie) {
+    radix_index_t index;
+
+    _trie_compact_abort_relayout(trie);
+    for (index = RADIX_COMPACT_ROOT; index < trie->node_count; index++) {
+        if (RADIX_COMPACT_IS_BUCKET(trie, index)) {
+            free(RADIX_COMPACT_NODE(trie, index)->val);
+        }
+    }
+    free(trie->nodes);
+    free(trie->labels);
+    free(trie);
+}
+
+// returns the value that was set
+void *
+trie_compact_set_key (radix_compact_t *trie, const char *key, void *val) {
+    radix_compact_bucket_t *bucket;
+    radix_index_t index, child, prev, leaf;
+    const char *label, *full_key;
+    uint32_t len, match_len, off;
+    int found;
+
+    if (val == NULL && trie->bucket_threshold != 0) {
+        // buckets only hold real values
+        trie_compact_delete_key(trie, key);
+        return NULL;
+    }
+
+    full_key = key;
+
+    index = RADIX_COMPACT_ROOT;
+    while (key[0] != 0 && !RADIX_COMPACT_IS_BUCKET(trie, index)) {
+        child = _trie_compact_find_child(trie, index, key[0], &prev);
+
+        if (child == 0) {
+            // nothing shares our first byte, so we're a new child of this node
+            leaf = _trie_compact_new_leaf(trie, key, val);
+            _trie_compact_link_child(trie, index, prev, leaf);
+            goto done;
+        }
+
+        label = _trie_compact_label(trie, RADIX_COMPACT_NODE(trie, child), &len);
+        match_len = _trie_compact_match(label, len, key);
+        key += match_len;
+
+        if (match_len < len) {
+            // the child matched partially, so split it where the key stops agreeing
+            _trie_compact_split_node(trie, child, match_len);
+            if (key[0] != 0) {
+                leaf = _trie_compact_new_leaf(trie, key, val);
+                _trie_compact_find_child(trie, child, key[0], &prev);
+                _trie_compact_link_child(trie, child, prev, leaf);
+                goto done;
+            }
+            index = child;
+            break;
+        }
+
+        index = child;
+    }
+
+    if (RADIX_COMPACT_IS_BUCKET(trie, index)) {
+        bucket = (radix_compact_bucket_t *)RADIX_COMPACT_NODE(trie, index)->val;
+        len = strlen(key);
+        off = _trie_compact_bucket_find(bucket, key, len, &found);
+        if (found) {
+            memcpy(bucket->entries + off + sizeof(uint32_t) + len, &val, sizeof(void *));
+            goto done;
+        }
+
+        bucket = _trie_compact_bucket_insert(trie, bucket, off, NULL, 0, key, len, val);
+        RADIX_COMPACT_NODE(trie, index)->val = bucket;
+        trie->count++;
+        if (bucket->count > trie->bucket_threshold) {
+            _trie_compact_burst(trie, index);
+        }
+        goto done;
+    }
+
+    if (RADIX_COMPACT_NODE(trie, index)->val == NULL && val != NULL) {
+        trie->count++;
+    } else if (RADIX_COMPACT_NODE(trie, index)->val != NULL && val == NULL) {
+        trie->count--;
+    }
+    RADIX_COMPACT_NODE(trie, index)->val = val;
+
+done:
+    // a relayout in progress keeps its copy in step, see trie_compact_relayout
+    if (trie->relayout_nodes != NULL) {
+        _trie_compact_relayout_path(trie, full_key);
+    }
+    return val;
+}
+
+// returns the value associated with the key, or NULL
+void *
+trie_compact_get_key (radix_compact_t *trie, const char *key) {
+    radix_compact_bucket_t *bucket;
+    radix_index_t index;
+    uint32_t off;
+    int found;
+
+    index = _trie_compact_get_node(trie, key, &key);
+    if (index == 0) {
+        return NULL;
+    }
+
+    if (RADIX_COMPACT_IS_BUCKET(trie, index)) {
+        bucket = (radix_compact_bucket_t *)RADIX_COMPACT_NODE(trie, index)->val;
+        off = _trie_compact_bucket_find(bucket, key, strlen(key), &found);
+        return found ? _trie_compact_entry_val(bucket, off) : NULL;
+    }
+
+    return RADIX_COMPACT_NODE(trie, index)->val;
+}
+
+// returns the value contained by key after deleting it
+void *
+trie_compact_delete_key (radix_compact_t *trie, const char *key) {
+    radix_compact_bucket_t *bucket;
+    radix_index_t index, parent, prev;
+    radix_index_t path_buf[RADIX_COMPACT_PATH], *path;
+    size_t depth, path_size;
+    radix_compact_node_t *node;
+    const char *label;
+    uint32_t len, off;
+    const char *full_key = key;
+    void *val;
+    int found;
+
+    // hybrid tries collapse up the path afterwards, so remember every ancestor on the way down
+    path = path_buf;
+    path_size = RADIX_COMPACT_PATH;
+    depth = 0;
+    val = NULL;
+
+    parent = 0;
+    prev = 0;
+    index = RADIX_COMPACT_ROOT;
+    while (key[0] != 0 && !RADIX_COMPACT_IS_BUCKET(trie, index)) {
+        parent = index;
+        path = _trie_compact_push_path(path, path_buf, &path_size, depth++, parent);
+        index = _trie_compact_find_child(trie, parent, key[0], &prev);
+        if (index == 0) {
+            goto done;
+        }
+        label = _trie_compact_label(trie, RADIX_COMPACT_NODE(trie, index), &len);
+        if (strncmp(label, key, len) != 0) {
+            goto done;
+        }
+        key += len;
+    }
+
+    node = RADIX_COMPACT_NODE(trie, index);
+    if (node->child == RADIX_COMPACT_BUCKET) {
+        bucket = (radix_compact_bucket_t *)node->val;
+        off = _trie_compact_bucket_find(bucket, key, strlen(key), &found);
+        if (!found) {
+            goto done;
+        }
+        val = _trie_compact_entry_val(bucket, off);
+        _trie_compact_bucket_remove(bucket, off);
+        trie->count--;
+
+        if (bucket->count == 0 && parent != 0) {
+            // an empty bucket leaf goes away like any other leaf
+            _trie_compact_free_bucket(trie, bucket);
+            node->val = NULL;
+            node->child = 0;
+        } else {
+            _trie_compact_collapse_path(trie, path, depth);
+            goto done;
+        }
+    } else {
+        val = node->val;
+        if (val == NULL) {
+            goto done;
+        }
+        node->val = NULL;
+        trie->count--;
+    }
+
+    if (parent == 0) {
+        goto done;
+    }
+
+    if (node->child != 0) {
+        _trie_compact_merge_node_with_child(trie, index);
+    } else {
+        // unlink the leaf, then fold its parent into a remaining only child
+        if (prev == 0) {
+            RADIX_COMPACT_NODE(trie, parent)->child = node->right;
+        } else {
+            RADIX_COMPACT_NODE(trie, prev)->right = node->right;
+        }
+        _trie_compact_free_node(trie, index);
+        _trie_compact_merge_node_with_child(trie, parent);
+        _trie_compact_collapse_path(trie, path, depth);
+    }
+
+done:
+    if (path != path_buf) {
+        free(path);
+    }
+    if (trie->relayout_nodes != NULL && val != NULL) {
+        _trie_compact_relayout_path(trie, full_key);
+    }
+    return val;
+}
+
+// returns the value of the longest key that is a prefix of key (or NULL), and by reference the
+//      part of key past it
+void *
+trie_compact_get_longest_match (radix_compact_t *trie, const char *key, char **remainder) {
+    radix_compact_bucket_t *bucket;
+    radix_index_t index, prev;
+    const char *label;
+    uint32_t len, off;
+    void *val;
+
+    index = RADIX_COMPACT_ROOT;
+    val = NULL;
+    *remainder = (char *)key;
+
+    for (;;) {
+        if (RADIX_COMPACT_IS_BUCKET(trie, index)) {
+            // entries are sorted, so the last one that is a prefix of the key is the longest
+            bucket = (radix_compact_bucket_t *)RADIX_COMPACT_NODE(trie, index)->val;
+            for (off = 0; off < bucket->used; off = _trie_compact_entry_next(bucket, off)) {
+                len = _trie_compact_entry_len(bucket, off);
+                if (strncmp(_trie_compact_entry_key(bucket, off), key, len) == 0) {
+                    val = _trie_compact_entry_val(bucket, off);
+                    *remainder = (char *)key + len;
+                }
+            }
+            break;
+        }
+
+        if (RADIX_COMPACT_NODE(trie, index)->val != NULL) {
+            val = RADIX_COMPACT_NODE(trie, index)->val;
+            *remainder = (char *)key;
+        }
+        if (key[0] == 0) {
+            break;
+        }
+
+        index = _trie_compact_find_child(trie, index, key[0], &prev);
+        if (index == 0) {
+            break;
+        }
+        label = _trie_compact_label(trie, RADIX_COMPACT_NODE(trie, index), &len);
+        if (strncmp(label, key, len) != 0) {
+            break;
+        }
+        key += len;
+    }
+
+    return val;
+}
+
+// calls callback with every key and value in key order, returns how many there were
+size_t
+trie_compact_recurse (radix_compact_t *trie, trie_compact_callback callback) {
+    radix_compact_key_t key;
+    size_t found;
+
+    key.size = 64;
+    key.len = 0;
+    key.key = (char *)malloc(key.size);
+
+    found = _trie_compact_recurse(trie, RADIX_COMPACT_ROOT, &key, callback);
+
+    free(key.key);
+    return found;
+}
+
+// returns how many bytes the trie has allocated
+size_t
+trie_compact_memory (radix_compact_t *trie) {
+    return sizeof(radix_compact_t) + trie->node_capacity * sizeof(radix_compact_node_t) +
+        trie->label_capacity + trie->bucket_bytes;
+}
+
+// copy the trie's nodes and long labels into fresh memory in depth first order, so that a lookup
+//      walks forward through memory instead of hopping around the heap.  Copies at most 'budget'
+//      nodes per call (0 means no limit) and returns 1 once the new layout is in place, 0 while
+//      there's more to do.  Lookups and writes can run between calls: a write updates the copies of
+//      the nodes it changed and queues any new ones, so it stays about as cheap as without a
+//      relayout and the relayout still gets done
+int
+trie_compact_relayout (radix_compact_t *trie, size_t budget) {
+    size_t moved = 0;
+
+    if (trie->relayout_nodes == NULL) {
+        _trie_compact_start_relayout(trie);
+    }
+
+    while (trie->relayout_depth > 0) {
+        if (budget != 0 && moved++ == budget) {
+            return 0;
+        }
+        _trie_compact_relayout_node(trie);
+    }
+
+    _trie_compact_finish_relayout(trie);
+    return 1;
+}
+
+#ifdef __cplusplus
+} // extern "C"
+#endif // #ifdef __cplusplus
+
+#endif // #ifndef _GRAT_RADIX_TRIE_COMPACT_H_
@@ -0,0 +1,464 @@
+/*
+ * Copyright (c) 2009, Elliot Foster (elliot dash source at grat dot net)
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 
+ * * Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ * 
+ * * Redistributions in binary form must reproduce the above
+ * copyright notice, this list of conditions and the following disclaimer
+ * in the documentation and/or other materials provided with the
+ * distribution.
+ * 
+ * * Neither the name of Gratuitous, Inc. nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * 
+ */
+
+#ifndef _GRAT_RADIX_TRIE_HOPE_H_
+#define _GRAT_RADIX_TRIE_HOPE_H_ 1
+
+#ifdef __cplusplus
+extern "C" {
+#endif // #ifdef __cplusplus
+
+#include <stdint.h>
+#include "grat_radix_trie.h"
+
+/*
+ *  Order-preserving key compression in the style of HOPE's single-character scheme: every byte gets
+ *      a variable length alphabetic (Hu-Tucker) code trained on a sample of keys, so common bytes
+ *      take fewer bits while encoded keys still sort exactly like the originals.  A sorting-first
+ *      end-of-key symbol goes after every key so that no encoded key is a prefix of another.
+ *
+ *  The bits are packed seven to a byte with the high bit set, so encoded keys never contain a NUL
+ *      and compare the same way whether char is signed or not.  Symbols are ranked the way the
+ *      trie orders siblings (plain char comparison), so trie order is preserved too.
+ */
+
+// symbol 0 is the end of a key, the other 255 are the non-NUL bytes in char order
+#define RADIX_HOPE_SYMBOLS 256
+// encoded keys that fit go through a buffer on the stack
+#define RADIX_HOPE_STACK 512
+
+typedef struct {
+    uint64_t code[RADIX_HOPE_SYMBOLS];
+    unsigned char len[RADIX_HOPE_SYMBOLS];
+    unsigned char symbol[256];          // byte -> symbol
+    unsigned char byte[RADIX_HOPE_SYMBOLS];  // symbol -> byte
+
+    // decoding tree: node 0 is the root, a negative entry is -(symbol + 1)
+    int decode[2 * RADIX_HOPE_SYMBOLS][2];
+} radix_hope_t;
+
+// PUBLIC METHOD DEFINITIONS/PROTOTYPES
+radix_hope_t * trie_hope_train (const char **keys, size_t num_keys);
+void trie_hope_destroy (radix_hope_t *hope);
+size_t trie_hope_encoded_len (const radix_hope_t *hope, const char *key);
+size_t trie_hope_encode (const radix_hope_t *hope, const char *key, char *out, size_t out_len);
+size_t trie_hope_decode (const radix_hope_t *hope, const char *encoded, char *out, size_t out_len);
+void * trie_hope_set_key (radix_t *root_node, const radix_hope_t *hope, const char *key,
+        void *val);
+void * trie_hope_get_key (radix_t *root_node, const radix_hope_t *hope, const char *key);
+void * trie_hope_delete_key (radix_t *root_node, const radix_hope_t *hope, const char *key);
+size_t trie_hope_count_prefix (radix_t *root_node, const radix_hope_t *hope, const char *prefix);
+size_t trie_hope_rank (radix_t *root_node, const radix_hope_t *hope, const char *key);
+void * trie_hope_select (radix_t *root_node, const radix_hope_t *hope, size_t index, char *key,
+        size_t key_len);
+
+// PRIVATE METHODS
+
+// compute optimal alphabetic code lengths with the Garsia-Wachs algorithm.  Quadratic, which is
+//      nothing for 256 symbols
+void
+_trie_hope_code_lengths (const uint64_t *weights, unsigned char *lengths) {
+    uint64_t weight[RADIX_HOPE_SYMBOLS + 2];
+    int tree[RADIX_HOPE_SYMBOLS + 2];
+    int parent[2 * RADIX_HOPE_SYMBOLS];
+    int count, next_node, i, j, k, depth;
+    uint64_t combined;
+
+    // working sequence with infinite sentinels at both ends
+    weight[0] = (uint64_t)-1;
+    tree[0] = -1;
+    for (i = 0; i < RADIX_HOPE_SYMBOLS; i++) {
+        weight[i + 1] = weights[i];
+        tree[i + 1] = i;
+    }
+    count = RADIX_HOPE_SYMBOLS;
+    weight[count + 1] = (uint64_t)-1;
+    tree[count + 1] = -1;
+    next_node = RADIX_HOPE_SYMBOLS;
+
+    while (count > 1) {
+        // combine the first pair whose left neighbour is no heavier than its right neighbour
+        for (k = 2; k < count && weight[k - 1] > weight[k + 1]; k++) {
+            continue;
+        }
+        combined = weight[k - 1] + weight[k];
+        parent[tree[k - 1]] = next_node;
+        parent[tree[k]] = next_node;
+
+        for (i = k - 1; i < count; i++) {
+            weight[i] = weight[i + 2];
+            tree[i] = tree[i + 2];
+        }
+        count -= 2;
+
+        // and move the result left, to just after the nearest heavier tree
+        for (j = k - 2; weight[j] < combined; j--) {
+            continue;
+        }
+        for (i = count + 1; i > j; i--) {
+            weight[i + 1] = weight[i];
+            tree[i + 1] = tree[i];
+        }
+        weight[j + 1] = combined;
+        tree[j + 1] = next_node++;
+        count++;
+    }
+    parent[tree[1]] = -1;
+
+    for (i = 0; i < RADIX_HOPE_SYMBOLS; i++) {
+        depth = 0;
+        for (j = i; parent[j] != -1; j = parent[j]) {
+            depth++;
+        }
+        lengths[i] = depth;
+    }
+}
+
+// assign codes left to right from the lengths, which gives an alphabetic prefix code, and build
+//      the tree used to decode it
+void
+_trie_hope_assign_codes (radix_hope_t *hope) {
+    uint64_t code = 0;
+    int i, bit, node, next_node;
+
+    for (i = 0; i < RADIX_HOPE_SYMBOLS; i++) {
+        if (i > 0) {
+            code++;
+            if (hope->len[i] >= hope->len[i - 1]) {
+                code <<= hope->len[i] - hope->len[i - 1];
+            } else {
+                code >>= hope->len[i - 1] - hope->len[i];
+            }
+        }
+        hope->code[i] = code;
+    }
+
+    memset(hope->decode, 0, sizeof(hope->decode));
+    next_node = 1;
+    for (i = 0; i < RADIX_HOPE_SYMBOLS; i++) {
+        node = 0;
+        for (bit = hope->len[i] - 1; bit > 0; bit--) {
+            if (hope->decode[node][(hope->code[i] >> bit) & 1] == 0) {
+                hope->decode[node][(hope->code[i] >> bit) & 1] = next_node++;
+            }
+            node = hope->decode[node][(hope->code[i] >> bit) & 1];
+        }
+        hope->decode[node][hope->code[i] & 1] = -(i + 1);
+    }
+}
+
+typedef struct {
+    char *out;
+    size_t out_len;
+    size_t len;
+    uint64_t bits;
+    int num_bits;
+} radix_hope_writer_t;
+
+// append a code, handing out seven bits at a time
+void
+_trie_hope_put_bits (radix_hope_writer_t *writer, uint64_t code, int len) {
+    if (len > 32) {
+        _trie_hope_put_bits(writer, code >> 32, len - 32);
+        code &= 0xffffffff;
+        len = 32;
+    }
+
+    writer->bits = (writer->bits << len) | code;
+    writer->num_bits += len;
+    while (writer->num_bits >= 7) {
+        writer->num_bits -= 7;
+        if (writer->len < writer->out_len) {
+            writer->out[writer->len] = (char)(0x80 | ((writer->bits >> writer->num_bits) & 0x7f));
+        }
+        writer->len++;
+    }
+    writer->bits &= ((uint64_t)1 << writer->num_bits) - 1;
+}
+
+// encode key (followed by the end-of-key symbol if 'terminate') into writer
+void
+_trie_hope_write (const radix_hope_t *hope, const char *key, int terminate,
+        radix_hope_writer_t *writer) {
+    unsigned char symbol;
+
+    for (; key[0] != 0; key++) {
+        symbol = hope->symbol[(unsigned char)key[0]];
+        _trie_hope_put_bits(writer, hope->code[symbol], hope->len[symbol]);
+    }
+    if (terminate) {
+        _trie_hope_put_bits(writer, hope->code[0], hope->len[0]);
+    }
+}
+
+// the range of encoded keys starting with prefix is: keys starting with the first 'len' bytes
+//      of 'out' whose next byte is between *low and *high (when the prefix didn't end on a byte)
+size_t
+_trie_hope_encode_prefix (const radix_hope_t *hope, const char *prefix, char *out, size_t out_len,
+        unsigned char *low, unsigned char *high) {
+    radix_hope_writer_t writer;
+    int free_bits;
+
+    writer.out = out;
+    writer.out_len = out_len;
+    writer.len = 0;
+    writer.bits = 0;
+    writer.num_bits = 0;
+    _trie_hope_write(hope, prefix, 0, &writer);
+
+    free_bits = 7 - writer.num_bits;
+    *low = (unsigned char)(0x80 | (writer.bits << free_bits));
+    *high = *low | ((1 << free_bits) - 1);
+    if (writer.len < out_len) {
+        out[writer.len] = 0;
+    }
+
+    return writer.len;
+}
+
+// PUBLIC METHOD IMPLEMENTATIONS
+
+// build an encoder from the byte frequencies of a sample of keys.  Bytes that never show up in the
+//      sample still get a (long) code, so any key can be encoded
+radix_hope_t *
+trie_hope_train (const char **keys, size_t num_keys) {
+    radix_hope_t *hope = (radix_hope_t *)malloc(sizeof(radix_hope_t));
+    uint64_t weights[RADIX_HOPE_SYMBOLS];
+    const char *key;
+    int byte, symbol;
+    size_t i;
+
+    // symbols in the order the trie sorts bytes
+    symbol = 1;
+    for (byte = -128; byte < 128; byte++) {
+        if (byte != 0) {
+            hope->symbol[(unsigned char)byte] = symbol;
+            hope->byte[symbol] = (unsigned char)byte;
+            symbol++;
+        }
+    }
+    hope->symbol[0] = 0;
+    hope->byte[0] = 0;
+
+    for (i = 0; i < RADIX_HOPE_SYMBOLS; i++) {
+        weights[i] = 1;
+    }
+    for (i = 0; i < num_keys; i++) {
+        for (key = keys[i]; key[0] != 0; key++) {
+            weights[hope->symbol[(unsigned char)key[0]]] += 16;
+        }
+        weights[0] += 16;
+    }
+
+    _trie_hope_code_lengths(weights, hope->len);
+    _trie_hope_assign_codes(hope);
+
+    return hope;
+}
+
+void
+trie_hope_destroy (radix_hope_t *hope) {
+    free(hope);
+}
+
+// returns how many bytes key takes encoded, not counting the NUL
+size_t
+trie_hope_encoded_len (const radix_hope_t *hope, const char *key) {
+    size_t bits = hope->len[0];
+
+    for (; key[0] != 0; key++) {
+        bits += hope->len[hope->symbol[(unsigned char)key[0]]];
+    }
+
+    return (bits + 6) / 7;
+}
+
+// encode key into out (NUL terminated if it fits), returns the encoded length like strlcpy
+size_t
+trie_hope_encode (const radix_hope_t *hope, const char *key, char *out, size_t out_len) {
+    radix_hope_writer_t writer;
+
+    writer.out = out;
+    writer.out_len = out_len;
+    writer.len = 0;
+    writer.bits = 0;
+    writer.num_bits = 0;
+    _trie_hope_write(hope, key, 1, &writer);
+
+    // pad the last byte out with zeros
+    if (writer.num_bits > 0) {
+        _trie_hope_put_bits(&writer, 0, 7 - writer.num_bits);
+    }
+    if (out_len > 0) {
+        out[writer.len < out_len ? writer.len : out_len - 1] = 0;
+    }
+
+    return writer.len;
+}
+
+// decode an encoded key into out (NUL terminated, truncated if need be), returns its full length
+size_t
+trie_hope_decode (const radix_hope_t *hope, const char *encoded, char *out, size_t out_len) {
+    size_t len = 0;
+    int node = 0;
+    int bit;
+
+    for (; encoded[0] != 0; encoded++) {
+        for (bit = 6; bit >= 0; bit--) {
+            node = hope->decode[node][(encoded[0] >> bit) & 1];
+            if (node >= 0) {
+                continue;
+            }
+            if (node == -1) {
+                // end of key, anything left is padding
+                if (out_len > 0) {
+                    out[len < out_len ? len : out_len - 1] = 0;
+                }
+                return len;
+            }
+            if (len + 1 < out_len) {
+                out[len] = hope->byte[-node - 1];
+            }
+            len++;
+            node = 0;
+        }
+    }
+
+    if (out_len > 0) {
+        out[len < out_len ? len : out_len - 1] = 0;
+    }
+    return len;
+}
+
+// the set/get/delete wrappers encode into a buffer on the stack when the key is short enough
+#define _TRIE_HOPE_WITH_KEY(hope, key, encoded, body) do { \
+        char _stack[RADIX_HOPE_STACK]; \
+        size_t _len = trie_hope_encoded_len(hope, key) + 1; \
+        char *encoded = _len <= sizeof(_stack) ? _stack : (char *)malloc(_len); \
+        trie_hope_encode(hope, key, encoded, _len); \
+        body; \
+        if (encoded != _stack) { \
+            free(encoded); \
+        } \
+    } while (0)
+
+void *
+trie_hope_set_key (radix_t *root_node, const radix_hope_t *hope, const char *key, void *val) {
+    _TRIE_HOPE_WITH_KEY(hope, key, encoded, val = trie_set_key(root_node, encoded, val));
+    return val;
+}
+
+void *
+trie_hope_get_key (radix_t *root_node, const radix_hope_t *hope, const char *key) {
+    void *val;
+
+    _TRIE_HOPE_WITH_KEY(hope, key, encoded, val = trie_get_key(root_node, encoded));
+    return val;
+}
+
+void *
+trie_hope_delete_key (radix_t *root_node, const radix_hope_t *hope, const char *key) {
+    void *val;
+
+    _TRIE_HOPE_WITH_KEY(hope, key, encoded, val = trie_delete_key(root_node, encoded));
+    return val;
+}
+
+// returns how many keys sort before key
+size_t
+trie_hope_rank (radix_t *root_node, const radix_hope_t *hope, const char *key) {
+    size_t rank;
+
+    _TRIE_HOPE_WITH_KEY(hope, key, encoded, rank = trie_rank(root_node, encoded));
+    return rank;
+}
+
+// returns how many keys start with prefix.  A prefix rarely ends on a byte boundary once encoded,
+//      so this counts the keys whose encoding starts with the prefix's whole bytes and continues
+//      with a byte in the range its leftover bits allow, using two rank lookups
+size_t
+trie_hope_count_prefix (radix_t *root_node, const radix_hope_t *hope, const char *prefix) {
+    char stack[RADIX_HOPE_STACK + 2];
+    char *encoded = stack;
+    unsigned char low, high;
+    size_t len, count, upper;
+
+    len = trie_hope_encoded_len(hope, prefix) + 2;
+    if (len > sizeof(stack)) {
+        encoded = (char *)malloc(len);
+    }
+    len = _trie_hope_encode_prefix(hope, prefix, encoded, len, &low, &high);
+
+    if (low == 0x80 && high == 0xff) {
+        count = trie_count_prefix(root_node, encoded);
+    } else {
+        if (high == 0xff) {
+            upper = trie_rank(root_node, encoded) + trie_count_prefix(root_node, encoded);
+        } else {
+            encoded[len] = (char)(high + 1);
+            encoded[len + 1] = 0;
+            upper = trie_rank(root_node, encoded);
+        }
+        encoded[len] = (char)low;
+        encoded[len + 1] = 0;
+        count = upper - trie_rank(root_node, encoded);
+    }
+
+    if (encoded != stack) {
+        free(encoded);
+    }
+    return count;
+}
+
+// returns the value of the index'th key in order, decoding the key itself into key (if not NULL).
+//      Encoded keys longer than RADIX_HOPE_STACK bytes come back truncated
+void *
+trie_hope_select (radix_t *root_node, const radix_hope_t *hope, size_t index, char *key,
+        size_t key_len) {
+    char encoded[RADIX_HOPE_STACK];
+    void *val;
+
+    val = trie_select(root_node, index, encoded, sizeof(encoded));
+    if (key != NULL) {
+        trie_hope_decode(hope, encoded, key, key_len);
+    }
+
+    return val;
+}
+
+#ifdef __cplusplus
+} // extern "C"
+#endif // #ifdef __cplusplus
+
+#endif // #ifndef _GRAT_RADIX_TRIE_HOPE_H_
@@ -0,0 +1,621 @@
+/*
+ * Copyright (c) 2009, Elliot Foster (elliot dash source at grat dot net)
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 
+ * * Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ * 
+ * * Redistributions in binary form must reproduce the above
+ * copyright notice, this list of conditions and the following disclaimer
+ * in the documentation and/or other materials provided with the
+ * distribution.
+ * 
+ * * Neither the name of Gratuitous, Inc. nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * 
+ */
+
+#ifndef _GRAT_RADIX_TRIE_SHM_H_
+#define _GRAT_RADIX_TRIE_SHM_H_ 1
+
+#ifdef __cplusplus
+extern "C" {
+#endif // #ifdef __cplusplus
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ *  A radix trie that lives entirely inside one caller-supplied block of memory (normally an mmap'd
+ *      or shm_open'd region) and links its nodes by offsets from the start of that block, so every
+ *      process can map it at a different address.
+ *
+ *  One process writes, any number of processes read.  Writers bump 'version' to an odd number
+ *      before touching the trie and back to even when done; readers retry if the version was odd or
+ *      changed while they looked.  Readers bounds-check every offset they follow, so a torn read
+ *      can only produce a result that gets thrown away, never a wild pointer.
+ *
+ *  Writers never change a node that is linked into the trie except for its value.  Anything else is
+ *      built off to the side and swapped in with a single store to the offset that links to it, so
+ *      the trie is whole after every store and a writer that dies mid-update leaves nothing worse
+ *      than a stale count and some unreachable blocks (see trie_shm_recover).
+ *
+ *  Values are plain 64 bit integers since pointers mean nothing in another process, 0 being "no
+ *      value" just like NULL is for radix_t.
+ */
+
+#define RADIX_SHM_MAGIC 0x67726174
+// block sizes go from 16 bytes up to 1GB by powers of two
+#define RADIX_SHM_CLASSES 27
+// how many times a reader re-checks the version before giving up on a writer that is slow or gone
+#ifndef RADIX_SHM_SPIN_LIMIT
+#define RADIX_SHM_SPIN_LIMIT (1 << 20)
+#endif
+
+typedef uint32_t radix_off_t;
+
+typedef struct {
+    uint32_t magic;
+    volatile uint32_t version;
+    radix_off_t size;
+    radix_off_t used;
+    radix_off_t root;
+    uint32_t count;
+    radix_off_t free_list[RADIX_SHM_CLASSES];
+} radix_shm_t;
+
+typedef struct {
+    radix_off_t key;
+    radix_off_t child;
+    radix_off_t right;
+    uint32_t unused;
+    uint64_t val;
+} radix_shm_node_t;
+
+// every block starts with its size class, padded to keep the block 8-byte aligned
+typedef struct {
+    uint32_t size_class;
+    uint32_t unused;
+} radix_shm_block_t;
+
+#define RADIX_SHM_PTR(shm, off) ((char *)(shm) + (off))
+#define RADIX_SHM_NODE(shm, off) ((radix_shm_node_t *)RADIX_SHM_PTR(shm, off))
+#define RADIX_SHM_KEY(shm, node) RADIX_SHM_PTR(shm, (node)->key)
+
+// PUBLIC METHOD DEFINITIONS/PROTOTYPES
+radix_shm_t * trie_shm_init (void *region, size_t size);
+radix_shm_t * trie_shm_attach (void *region);
+int trie_shm_set_key (radix_shm_t *shm, const char *key, uint64_t val);
+int trie_shm_get_key (radix_shm_t *shm, const char *key, uint64_t *val);
+uint64_t trie_shm_delete_key (radix_shm_t *shm, const char *key);
+void trie_shm_recover (radix_shm_t *shm);
+
+// PRIVATE METHODS
+
+radix_off_t
+_trie_shm_alloc (radix_shm_t *shm, size_t len) {
+    radix_shm_block_t *block;
+    radix_off_t off;
+    uint32_t size_class = 0;
+
+    len += sizeof(radix_shm_block_t);
+    while (size_class < RADIX_SHM_CLASSES && ((size_t)16 << size_class) < len) {
+        size_class++;
+    }
+    if (size_class == RADIX_SHM_CLASSES) {
+        return 0;
+    }
+
+    if (shm->free_list[size_class] != 0) {
+        off = shm->free_list[size_class];
+        shm->free_list[size_class] = *(radix_off_t *)RADIX_SHM_PTR(shm, off);
+    } else {
+        if ((size_t)shm->used + ((size_t)16 << size_class) > shm->size) {
+            return 0;
+        }
+        off = shm->used + sizeof(radix_shm_block_t);
+        shm->used += 16 << size_class;
+    }
+
+    block = (radix_shm_block_t *)RADIX_SHM_PTR(shm, off - sizeof(radix_shm_block_t));
+    block->size_class = size_class;
+
+    return off;
+}
+
+void
+_trie_shm_free (radix_shm_t *shm, radix_off_t off) {
+    radix_shm_block_t *block;
+
+    if (off == 0) {
+        return;
+    }
+
+    block = (radix_shm_block_t *)RADIX_SHM_PTR(shm, off - sizeof(radix_shm_block_t));
+    *(radix_off_t *)RADIX_SHM_PTR(shm, off) = shm->free_list[block->size_class];
+    shm->free_list[block->size_class] = off;
+}
+
+radix_off_t
+_trie_shm_strndup (radix_shm_t *shm, const char *key, size_t len) {
+    radix_off_t off = _trie_shm_alloc(shm, len + 1);
+
+    if (off != 0) {
+        memcpy(RADIX_SHM_PTR(shm, off), key, len);
+        RADIX_SHM_PTR(shm, off)[len] = 0;
+    }
+
+    return off;
+}
+
+radix_off_t
+_trie_shm_new_node (radix_shm_t *shm, const char *key, size_t len) {
+    radix_off_t off = _trie_shm_alloc(shm, sizeof(radix_shm_node_t));
+    radix_shm_node_t *node;
+
+    if (off == 0) {
+        return 0;
+    }
+
+    node = RADIX_SHM_NODE(shm, off);
+    node->key = _trie_shm_strndup(shm, key, len);
+    if (node->key == 0) {
+        _trie_shm_free(shm, off);
+        return 0;
+    }
+    node->child = 0;
+    node->right = 0;
+    node->unused = 0;
+    node->val = 0;
+
+    return off;
+}
+
+void
+_trie_shm_free_node (radix_shm_t *shm, radix_off_t off) {
+    _trie_shm_free(shm, RADIX_SHM_NODE(shm, off)->key);
+    _trie_shm_free(shm, off);
+}
+
+// returns the node at off, or NULL if off doesn't point at a whole node inside the region
+radix_shm_node_t *
+_trie_shm_checked_node (radix_shm_t *shm, radix_off_t off) {
+    if (off < sizeof(radix_shm_t) || (size_t)off + sizeof(radix_shm_node_t) > shm->size) {
+        return NULL;
+    }
+
+    return RADIX_SHM_NODE(shm, off);
+}
+
+// like _trie_string_cmp, but never reads past the end of the region
+size_t
+_trie_shm_string_cmp (radix_shm_t *shm, radix_off_t key, const char *b) {
+    const char *a = RADIX_SHM_PTR(shm, key);
+    size_t bytes = 0;
+
+    while ((size_t)key + bytes < shm->size && a[bytes] != '\0' && b[bytes] != '\0' &&
+            a[bytes] == b[bytes]) {
+        bytes++;
+    }
+
+    return bytes;
+}
+
+// returns the child of node whose key starts with byte, or 0.  Sets *prev to the sibling in front
+//      of it (or 0 if it's the first child, or where a new child with that byte would go)
+radix_off_t
+_trie_shm_find_child (radix_shm_t *shm, radix_shm_node_t *node, char byte, radix_off_t *prev) {
+    radix_shm_node_t *child;
+    radix_off_t off = node->child;
+    uint32_t steps = 0;
+
+    *prev = 0;
+    // there can't be more siblings than there are distinct bytes
+    while (steps++ < 256 && (child = _trie_shm_checked_node(shm, off)) != NULL &&
+            child->key < shm->size) {
+        if (RADIX_SHM_PTR(shm, child->key)[0] == byte) {
+            return off;
+        }
+        if (RADIX_SHM_PTR(shm, child->key)[0] > byte) {
+            break;
+        }
+        *prev = off;
+        off = child->right;
+    }
+
+    return 0;
+}
+
+// returns the node holding exactly key, or 0.  Safe to run against a trie that is being modified
+radix_off_t
+_trie_shm_get_node (radix_shm_t *shm, const char *key) {
+    radix_shm_node_t *node;
+    radix_off_t off, prev;
+    size_t match_len;
+    uint32_t steps = 0;
+
+    off = shm->root;
+    while (key[0] != 0) {
+        if (steps++ > shm->size / sizeof(radix_shm_node_t) ||
+                (node = _trie_shm_checked_node(shm, off)) == NULL) {
+            return 0;
+        }
+        off = _trie_shm_find_child(shm, node, key[0], &prev);
+        if ((node = _trie_shm_checked_node(shm, off)) == NULL) {
+            return 0;
+        }
+
+        match_len = _trie_shm_string_cmp(shm, node->key, key);
+        if ((size_t)node->key + match_len >= shm->size ||
+                RADIX_SHM_PTR(shm, node->key)[match_len] != 0) {
+            return 0;
+        }
+        key += match_len;
+    }
+
+    return off;
+}
+
+// returns the offset field that links to the child of parent after prev, or to parent's first child
+//      if prev is 0
+radix_off_t *
+_trie_shm_link (radix_shm_t *shm, radix_off_t parent, radix_off_t prev) {
+    if (prev == 0) {
+        return &RADIX_SHM_NODE(shm, parent)->child;
+    }
+
+    return &RADIX_SHM_NODE(shm, prev)->right;
+}
+
+// publish a change: once everything it links to is written, one store puts it in the trie
+void
+_trie_shm_commit (radix_off_t *link, radix_off_t off) {
+    __sync_synchronize();
+    *(volatile radix_off_t *)link = off;
+}
+
+// replace the valueless node that link points to with a copy merged with its only child.  Leaves
+//      the node alone if there isn't room for the copy, which costs some compression but nothing else
+void
+_trie_shm_merge_node_with_child (radix_shm_t *shm, radix_off_t *link) {
+    radix_shm_node_t *node, *child, *merged;
+    radix_off_t off, child_off, merged_off, new_key;
+    size_t len, child_len;
+
+    off = *link;
+    node = RADIX_SHM_NODE(shm, off);
+    child_off = node->child;
+    if (node->val != 0 || child_off == 0) {
+        return;
+    }
+    child = RADIX_SHM_NODE(shm, child_off);
+    if (child->right != 0) {
+        return;
+    }
+
+    len = strlen(RADIX_SHM_KEY(shm, node));
+    child_len = strlen(RADIX_SHM_KEY(shm, child));
+    new_key = _trie_shm_alloc(shm, len + child_len + 1);
+    merged_off = new_key != 0 ? _trie_shm_alloc(shm, sizeof(radix_shm_node_t)) : 0;
+    if (merged_off == 0) {
+        _trie_shm_free(shm, new_key);
+        return;
+    }
+    memcpy(RADIX_SHM_PTR(shm, new_key), RADIX_SHM_KEY(shm, node), len);
+    memcpy(RADIX_SHM_PTR(shm, new_key) + len, RADIX_SHM_KEY(shm, child), child_len + 1);
+
+    merged = RADIX_SHM_NODE(shm, merged_off);
+    merged->key = new_key;
+    merged->child = child->child;
+    merged->right = node->right;
+    merged->unused = 0;
+    merged->val = child->val;
+
+    _trie_shm_commit(link, merged_off);
+    _trie_shm_free_node(shm, off);
+    _trie_shm_free_node(shm, child_off);
+}
+
+// returns how many keys the subtree at off holds
+uint32_t
+_trie_shm_count (radix_shm_t *shm, radix_off_t off) {
+    radix_shm_node_t *node = RADIX_SHM_NODE(shm, off);
+    uint32_t count = node->val != 0 ? 1 : 0;
+
+    for (off = node->child; off != 0; off = RADIX_SHM_NODE(shm, off)->right) {
+        count += _trie_shm_count(shm, off);
+    }
+
+    return count;
+}
+
+void
+_trie_shm_write_begin (radix_shm_t *shm) {
+    shm->version++;
+    __sync_synchronize();
+}
+
+void
+_trie_shm_write_end (radix_shm_t *shm) {
+    __sync_synchronize();
+    shm->version++;
+}
+
+// PUBLIC METHOD IMPLEMENTATIONS
+
+// format a region of memory as an empty trie, returns NULL if the region is too small
+radix_shm_t *
+trie_shm_init (void *region, size_t size) {
+    radix_shm_t *shm = (radix_shm_t *)region;
+
+    if (size > (radix_off_t)-1) {
+        size = (radix_off_t)-1;
+    }
+    if (size < sizeof(radix_shm_t)) {
+        return NULL;
+    }
+
+    memset(shm, 0, sizeof(radix_shm_t));
+    shm->size = size;
+    shm->used = (sizeof(radix_shm_t) + 7) & ~7;
+    shm->root = _trie_shm_new_node(shm, "", 0);
+    if (shm->root == 0) {
+        return NULL;
+    }
+
+    // the magic goes in last so nobody attaches to a half-formatted region
+    __sync_synchronize();
+    shm->magic = RADIX_SHM_MAGIC;
+
+    return shm;
+}
+
+// use a region formatted by trie_shm_init (possibly in another process), returns NULL if it isn't one
+radix_shm_t *
+trie_shm_attach (void *region) {
+    radix_shm_t *shm = (radix_shm_t *)region;
+
+    if (shm->magic != RADIX_SHM_MAGIC) {
+        return NULL;
+    }
+
+    return shm;
+}
+
+// returns 0 on success, -1 if the region is out of space (in which case the trie is unchanged).
+//      A val of 0 can't be told apart from a missing key, so setting 0 deletes the key instead.
+//      Only one process may write at a time
+int
+trie_shm_set_key (radix_shm_t *shm, const char *key, uint64_t val) {
+    radix_shm_node_t *node, *child, *prefix, *tail, *leaf;
+    radix_off_t off, child_off, prev, prefix_off, tail_off, leaf_off;
+    size_t match_len;
+    char *label;
+
+    if (val == 0) {
+        trie_shm_delete_key(shm, key);
+        return 0;
+    }
+
+    off = shm->root;
+    node = RADIX_SHM_NODE(shm, off);
+    while (key[0] != 0) {
+        child_off = _trie_shm_find_child(shm, node, key[0], &prev);
+
+        if (child_off == 0) {
+            // nothing shares our first byte, so we're a new child of this node
+            leaf_off = _trie_shm_new_node(shm, key, strlen(key));
+            if (leaf_off == 0) {
+                return -1;
+            }
+            leaf = RADIX_SHM_NODE(shm, leaf_off);
+            leaf->val = val;
+            leaf->right = *_trie_shm_link(shm, off, prev);
+
+            _trie_shm_write_begin(shm);
+            _trie_shm_commit(_trie_shm_link(shm, off, prev), leaf_off);
+            shm->count++;
+            _trie_shm_write_end(shm);
+            return 0;
+        }
+
+        child = RADIX_SHM_NODE(shm, child_off);
+        label = RADIX_SHM_KEY(shm, child);
+        match_len = _trie_shm_string_cmp(shm, child->key, key);
+
+        if (label[match_len] != 0) {
+            // the child matched partially, so build what replaces it: a node for the part we share
+            //      with the rest of the child and (unless we end there) our own leaf below it
+            prefix_off = _trie_shm_new_node(shm, key, match_len);
+            tail_off = 0;
+            if (prefix_off != 0) {
+                tail_off = _trie_shm_new_node(shm, label + match_len, strlen(label + match_len));
+            }
+            leaf_off = 0;
+            if (tail_off != 0 && key[match_len] != 0) {
+                leaf_off = _trie_shm_new_node(shm, key + match_len, strlen(key + match_len));
+            }
+            if (tail_off == 0 || (key[match_len] != 0 && leaf_off == 0)) {
+                // none of it was ever linked in, so no reader can be looking at it
+                if (prefix_off != 0) {
+                    _trie_shm_free_node(shm, prefix_off);
+                }
+                if (tail_off != 0) {
+                    _trie_shm_free_node(shm, tail_off);
+                }
+                return -1;
+            }
+
+            prefix = RADIX_SHM_NODE(shm, prefix_off);
+            tail = RADIX_SHM_NODE(shm, tail_off);
+            tail->val = child->val;
+            tail->child = child->child;
+            prefix->right = child->right;
+            prefix->child = tail_off;
+
+            if (leaf_off == 0) {
+                prefix->val = val;
+            } else {
+                leaf = RADIX_SHM_NODE(shm, leaf_off);
+                leaf->val = val;
+                if (RADIX_SHM_KEY(shm, tail)[0] < key[match_len]) {
+                    tail->right = leaf_off;
+                } else {
+                    leaf->right = tail_off;
+                    prefix->child = leaf_off;
+                }
+            }
+
+            _trie_shm_write_begin(shm);
+            _trie_shm_commit(_trie_shm_link(shm, off, prev), prefix_off);
+            shm->count++;
+            _trie_shm_free_node(shm, child_off);
+            _trie_shm_write_end(shm);
+            return 0;
+        }
+
+        key += match_len;
+        off = child_off;
+        node = child;
+    }
+
+    _trie_shm_write_begin(shm);
+    if (node->val == 0) {
+        shm->count++;
+    }
+    node->val = val;
+    _trie_shm_write_end(shm);
+
+    return 0;
+}
+
+// sets *val to the value stored under key (0 if there is none) and returns 0.  May be called from
+//      any process at any time.  Returns -1, leaving *val alone, if a writer kept the trie busy for
+//      RADIX_SHM_SPIN_LIMIT checks: it may only be slow, so trying again later is fine, but if it
+//      died mid-update every read fails this way until a new writer calls trie_shm_recover
+int
+trie_shm_get_key (radix_shm_t *shm, const char *key, uint64_t *val) {
+    radix_shm_node_t *node;
+    radix_off_t off;
+    uint32_t version;
+    uint64_t found;
+    unsigned long spins = 0;
+
+    do {
+        while ((version = shm->version) & 1) {
+            if (++spins >= RADIX_SHM_SPIN_LIMIT) {
+                return -1;
+            }
+        }
+        __sync_synchronize();
+
+        found = 0;
+        off = _trie_shm_get_node(shm, key);
+        if ((node = _trie_shm_checked_node(shm, off)) != NULL) {
+            found = node->val;
+        }
+
+        __sync_synchronize();
+    } while (shm->version != version && ++spins < RADIX_SHM_SPIN_LIMIT);
+
+    if (shm->version != version) {
+        return -1;
+    }
+    *val = found;
+    return 0;
+}
+
+// returns the value that was stored under key, or 0.  Only one process may write at a time
+uint64_t
+trie_shm_delete_key (radix_shm_t *shm, const char *key) {
+    radix_shm_node_t *node, *child;
+    radix_off_t off, parent_off, prev, grandparent_off, parent_prev;
+    size_t match_len;
+    uint64_t val;
+
+    grandparent_off = 0;
+    parent_off = 0;
+    parent_prev = 0;
+    prev = 0;
+    off = shm->root;
+    while (key[0] != 0) {
+        grandparent_off = parent_off;
+        parent_prev = prev;
+        parent_off = off;
+        off = _trie_shm_find_child(shm, RADIX_SHM_NODE(shm, off), key[0], &prev);
+        if (off == 0) {
+            return 0;
+        }
+        child = RADIX_SHM_NODE(shm, off);
+        match_len = _trie_shm_string_cmp(shm, child->key, key);
+        if (RADIX_SHM_KEY(shm, child)[match_len] != 0) {
+            return 0;
+        }
+        key += match_len;
+    }
+
+    node = RADIX_SHM_NODE(shm, off);
+    val = node->val;
+    if (val == 0) {
+        return 0;
+    }
+
+    // clearing the value is the delete, the rest only tidies up and leaves a whole trie at each step
+    _trie_shm_write_begin(shm);
+    node->val = 0;
+    shm->count--;
+
+    if (parent_off != 0) {
+        if (node->child != 0) {
+            _trie_shm_merge_node_with_child(shm, _trie_shm_link(shm, parent_off, prev));
+        } else {
+            // unlink the leaf, then fold its parent into a remaining only child
+            _trie_shm_commit(_trie_shm_link(shm, parent_off, prev), node->right);
+            _trie_shm_free_node(shm, off);
+
+            if (grandparent_off != 0) {
+                _trie_shm_merge_node_with_child(shm,
+                        _trie_shm_link(shm, grandparent_off, parent_prev));
+            }
+        }
+    }
+    _trie_shm_write_end(shm);
+
+    return val;
+}
+
+// called by whichever process takes over writing after the previous writer died.  Since every
+//      update goes in with one store the trie itself is whole; this recounts the keys (the count
+//      may be one off) and puts the version back to even so readers stop giving up.  Blocks the
+//      dead writer had allocated but not linked in, or unlinked but not freed, stay lost
+void
+trie_shm_recover (radix_shm_t *shm) {
+    shm->count = _trie_shm_count(shm, shm->root);
+    if (shm->version & 1) {
+        _trie_shm_write_end(shm);
+    }
+}
+
+#ifdef __cplusplus
+} // extern "C"
+#endif // #ifdef __cplusplus
+
+#endif // #ifndef _GRAT_RADIX_TRIE_SHM_H_
@@ -0,0 +1,400 @@
+#include <stdio.h>
+#include <time.h>
+#include "../src/grat_radix_trie.h"
+#include "../src/grat_radix_trie_compact.h"
+#include "../src/grat_radix_trie_hope.h"
+#include "http_headers.h"
+
+/*
+ * rough benchmark of the trie layouts: memory per key and lookups per second over a set of
+ *      URL-like keys.  Memory for radix_t is estimated by walking the nodes and rounding every
+ *      malloc() the way glibc does (8 bytes of header, 16 byte granularity, 32 byte minimum)
+ */
+
+#define NUM_KEYS 500000
+#define NUM_LOOKUPS 2000000
+
+static const char *hosts[] = { "www.example.com", "cdn.example.net", "api.grat.net",
+    "static.grat.net", "images.example.org" };
+static const char *dirs[] = { "users", "static", "api/v1", "api/v2", "images", "docs" };
+
+char **keys = NULL;
+
+static unsigned long
+bench_random(void) {
+    static unsigned long state = 88172645463325252UL;
+
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    return state;
+}
+
+static void
+make_keys(void) {
+    char key[256];
+    int i;
+
+    keys = (char **)malloc(NUM_KEYS * sizeof(char *));
+    for (i = 0; i < NUM_KEYS; i++) {
+        snprintf(key, sizeof(key), "http://%s/%s/%lu/%lx", hosts[bench_random() % 5],
+                dirs[bench_random() % 6], bench_random() % 100000, bench_random() % 0xffffff);
+        keys[i] = strdup(key);
+    }
+}
+
+static size_t
+malloc_size(size_t size) {
+    size = (size + 8 + 15) & ~(size_t)15;
+    return size < 32 ? 32 : size;
+}
+
+static size_t
+radix_memory(radix_t *node) {
+    size_t bytes = 0;
+
+    for (; node != NULL; node = node->right) {
+        bytes += malloc_size(sizeof(radix_t)) + malloc_size(strlen(node->key) + 1);
+        bytes += radix_memory(node->child);
+    }
+
+    return bytes;
+}
+
+static double
+seconds_since(clock_t start) {
+    return (double)(clock() - start) / CLOCKS_PER_SEC;
+}
+
+// 80% of these lookups miss: the key with its last character swapped for one never used
+static void
+bench_misses(radix_t *trie) {
+    radix_filter_t *filter = RADIX_INFO(trie)->filter;
+    char key[256];
+    clock_t start;
+    size_t found = 0;
+    int i;
+
+    start = clock();
+    for (i = 0; i < NUM_LOOKUPS; i++) {
+        strcpy(key, keys[bench_random() % NUM_KEYS]);
+        if (i % 5 != 0) {
+            key[strlen(key) - 1] = 'z';
+        }
+        found += trie_get_key(trie, key) != NULL;
+    }
+
+    printf("  %s filter: %6.2f M lookups/s, 80%% misses  (%lu found)\n",
+            filter == NULL ? "without" : filter->counting ? "counted" :
+            "with   ",
+            NUM_LOOKUPS / seconds_since(start) / 1e6, (unsigned long)found);
+}
+
+static void
+bench_radix(void) {
+    radix_t *trie = trie_new();
+    radix_filter_stats_t stats;
+    clock_t start;
+    size_t found = 0;
+    double insert, lookup;
+    int i;
+
+    start = clock();
+    for (i = 0; i < NUM_KEYS; i++) {
+        trie_set_key(trie, keys[i], keys[i]);
+    }
+    insert = seconds_since(start);
+
+    start = clock();
+    for (i = 0; i < NUM_LOOKUPS; i++) {
+        found += trie_get_key(trie, keys[bench_random() % NUM_KEYS]) != NULL;
+    }
+    lookup = seconds_since(start);
+
+    printf("radix_t:          %6.1f bytes/key  %6.2f M inserts/s  %6.2f M lookups/s  (%lu found)\n",
+            (double)radix_memory(trie) / trie->count, NUM_KEYS / insert / 1e6,
+            NUM_LOOKUPS / lookup / 1e6, (unsigned long)found);
+
+    // lookups that mostly miss, with and without the negative-lookup filter
+    bench_misses(trie);
+    trie_enable_filter(trie);
+    bench_misses(trie);
+    trie_count_filter_lookups(trie, 1);
+    bench_misses(trie);
+    trie_filter_stats(trie, &stats);
+    printf("  filter: %lu bytes, %.1f%% of lookups rejected, %.2f%% false positives\n",
+            (unsigned long)stats.memory, 100 * stats.hit_rate, 100 * stats.false_positive_rate);
+
+    trie_destroy(trie);
+}
+
+static void
+bench_compact(void) {
+    radix_compact_t *trie = trie_compact_new();
+    clock_t start;
+    size_t found = 0;
+    double insert, lookup;
+    int i;
+
+    start = clock();
+    for (i = 0; i < NUM_KEYS; i++) {
+        trie_compact_set_key(trie, keys[i], keys[i]);
+    }
+    insert = seconds_since(start);
+
+    start = clock();
+    for (i = 0; i < NUM_LOOKUPS; i++) {
+        found += trie_compact_get_key(trie, keys[bench_random() % NUM_KEYS]) != NULL;
+    }
+    lookup = seconds_since(start);
+
+    printf("radix_compact_t:  %6.1f bytes/key  %6.2f M inserts/s  %6.2f M lookups/s  (%lu found)\n",
+            (double)trie_compact_memory(trie) / trie->count, NUM_KEYS / insert / 1e6,
+            NUM_LOOKUPS / lookup / 1e6, (unsigned long)found);
+
+    // the same lookups once the nodes have been laid out depth first
+    trie_compact_relayout(trie, 0);
+    found = 0;
+    start = clock();
+    for (i = 0; i < NUM_LOOKUPS; i++) {
+        found += trie_compact_get_key(trie, keys[bench_random() % NUM_KEYS]) != NULL;
+    }
+    lookup = seconds_since(start);
+
+    printf("  after relayout: %6.1f bytes/key  %6.2f M lookups/s  (%lu found)\n",
+            (double)trie_compact_memory(trie) / trie->count, NUM_LOOKUPS / lookup / 1e6,
+            (unsigned long)found);
+
+    trie_compact_destroy(trie);
+}
+
+static void
+bench_hybrid(void) {
+    radix_compact_t *trie = trie_compact_new_hybrid(64);
+    clock_t start;
+    size_t found = 0;
+    double insert, lookup;
+    int i;
+
+    start = clock();
+    for (i = 0; i < NUM_KEYS; i++) {
+        trie_compact_set_key(trie, keys[i], keys[i]);
+    }
+    insert = seconds_since(start);
+
+    start = clock();
+    for (i = 0; i < NUM_LOOKUPS; i++) {
+        found += trie_compact_get_key(trie, keys[bench_random() % NUM_KEYS]) != NULL;
+    }
+    lookup = seconds_since(start);
+
+    printf("hybrid (64/bkt):  %6.1f bytes/key  %6.2f M inserts/s  %6.2f M lookups/s  (%lu found)\n",
+            (double)trie_compact_memory(trie) / trie->count, NUM_KEYS / insert / 1e6,
+            NUM_LOOKUPS / lookup / 1e6, (unsigned long)found);
+
+    trie_compact_destroy(trie);
+}
+
+// radix_t again, over HOPE-encoded keys trained on a 1% sample
+static void
+bench_hope(void) {
+    radix_t *trie = trie_new();
+    radix_hope_t *hope;
+    char encoded[256];
+    clock_t start;
+    size_t found = 0, raw = 0, packed = 0;
+    double train, encode, lookup;
+    int i;
+
+    start = clock();
+    hope = trie_hope_train((const char **)keys, NUM_KEYS / 100);
+    train = seconds_since(start);
+
+    start = clock();
+    for (i = 0; i < NUM_KEYS; i++) {
+        raw += strlen(keys[i]);
+        packed += trie_hope_encode(hope, keys[i], encoded, sizeof(encoded));
+    }
+    encode = seconds_since(start);
+
+    for (i = 0; i < NUM_KEYS; i++) {
+        trie_hope_set_key(trie, hope, keys[i], keys[i]);
+    }
+
+    start = clock();
+    for (i = 0; i < NUM_LOOKUPS; i++) {
+        found += trie_hope_get_key(trie, hope, keys[bench_random() % NUM_KEYS]) != NULL;
+    }
+    lookup = seconds_since(start);
+
+    printf("radix_t + hope:   %6.1f bytes/key  %6.2f M lookups/s  (%lu found)\n",
+            (double)radix_memory(trie) / trie->count, NUM_LOOKUPS / lookup / 1e6,
+            (unsigned long)found);
+    printf("  keys at %.1f%% of their size, %.0f ns/key to encode, %.1f ms to train\n",
+            100.0 * packed / raw, encode * 1e9 / NUM_KEYS, train * 1e3);
+
+    trie_destroy(trie);
+    trie_hope_destroy(hope);
+}
+
+// two copies of the keys, 0.1% of them changed in one, diffed with and without Merkle hashes
+static void
+bench_diff(void) {
+    radix_t *a = trie_new();
+    radix_t *b = trie_new();
+    clock_t start;
+    size_t changed, plain;
+    double hashed_time, plain_time;
+    int i;
+
+    for (i = 0; i < NUM_KEYS; i++) {
+        trie_set_key(a, keys[i], keys[i]);
+        trie_set_key(b, keys[i], keys[i]);
+    }
+    for (i = 0; i < NUM_KEYS / 1000; i++) {
+        trie_set_key(b, keys[bench_random() % NUM_KEYS], "changed");
+    }
+
+    start = clock();
+    plain = trie_diff(a, b, NULL);
+    plain_time = seconds_since(start);
+
+    trie_enable_hashing(a, trie_hash_pointer);
+    trie_enable_hashing(b, trie_hash_pointer);
+    start = clock();
+    changed = trie_diff(a, b, NULL);
+    hashed_time = seconds_since(start);
+
+    printf("diff, 0.1%% changed: %.2f ms with hashes, %.2f ms without  (%lu/%lu keys differ)\n",
+            hashed_time * 1e3, plain_time * 1e3, (unsigned long)changed, (unsigned long)plain);
+
+    trie_destroy(a);
+    trie_destroy(b);
+}
+
+// delete and re-insert a tenth of the keys at a time, deleting eagerly or through tombstones
+static void
+bench_churn(int tombstones) {
+    radix_t *trie = trie_new();
+    clock_t start;
+    double deletes = 0, maintain = 0;
+    int round, i;
+
+    for (i = 0; i < NUM_KEYS; i++) {
+        trie_set_key(trie, keys[i], keys[i]);
+    }
+    if (tombstones) {
+        trie_enable_tombstones(trie);
+    }
+
+    for (round = 0; round < 10; round++) {
+        start = clock();
+        for (i = round; i < NUM_KEYS; i += 10) {
+            trie_delete_key(trie, keys[i]);
+        }
+        deletes += seconds_since(start);
+
+        start = clock();
+        trie_maintain(trie, 0);
+        maintain += seconds_since(start);
+
+        for (i = round; i < NUM_KEYS; i += 10) {
+            trie_set_key(trie, keys[i], keys[i]);
+        }
+    }
+
+    printf("churn, %s:  %6.2f M deletes/s, %.1f ms maintaining\n",
+            tombstones ? "tombstones" : "eager     ", NUM_KEYS / deletes / 1e6, maintain * 1e3);
+
+    trie_destroy(trie);
+}
+
+// a static keyword table: the generated header matcher against trie_get_key, half hits half misses,
+//      less the cost of the loop itself
+static void
+bench_codegen(void) {
+    // volatile, or the compiler works the lookups of a fixed rotation out at compile time
+    static const char *volatile names[] = { "content-length", "host", "user-agent", "accept",
+        "x-forwarded-for", "cookie", "if-none-match", "x-request-id", "content-typo", "dnt" };
+    radix_t *trie = trie_new();
+    size_t lens[10];
+    clock_t start;
+    double overhead, generated, walked;
+    long found = 0;
+    int i, n;
+
+    for (i = 0; i < 10; i++) {
+        lens[i] = strlen(names[i]);
+        if (http_header(names[i], lens[i]) >= 0) {
+            trie_set_key(trie, names[i], (void *)names[i]);
+        }
+    }
+
+    // what picking the names costs by itself
+    start = clock();
+    for (i = 0; i < NUM_LOOKUPS * 10; i++) {
+        n = bench_random() % 10;
+        found += lens[n] > 3;
+    }
+    overhead = seconds_since(start);
+    found = 0;
+
+    start = clock();
+    for (i = 0; i < NUM_LOOKUPS * 10; i++) {
+        n = bench_random() % 10;
+        found += http_header(names[n], lens[n]) >= 0;
+    }
+    generated = seconds_since(start) - overhead;
+
+    start = clock();
+    for (i = 0; i < NUM_LOOKUPS * 10; i++) {
+        found += trie_get_key(trie, names[bench_random() % 10]) != NULL;
+    }
+    walked = seconds_since(start) - overhead;
+
+    printf("keyword table:  %.1f ns/lookup generated, %.1f ns/lookup trie_get_key  (%ld found)\n",
+            generated * 1e9 / (NUM_LOOKUPS * 10), walked * 1e9 / (NUM_LOOKUPS * 10), found);
+
+    // the same names in a fixed rotation, which the branch predictor learns
+    start = clock();
+    for (i = 0; i < NUM_LOOKUPS * 10; i++) {
+        found += http_header(names[i % 10], lens[i % 10]) >= 0;
+    }
+    generated = seconds_since(start);
+
+    start = clock();
+    for (i = 0; i < NUM_LOOKUPS * 10; i++) {
+        found += trie_get_key(trie, names[i % 10]) != NULL;
+    }
+    walked = seconds_since(start);
+
+    printf("  in rotation:  %.1f ns/lookup generated, %.1f ns/lookup trie_get_key\n",
+            generated * 1e9 / (NUM_LOOKUPS * 10), walked * 1e9 / (NUM_LOOKUPS * 10));
+
+    trie_destroy(trie);
+}
+
+int
+main(int argc, char **argv) {
+    int i;
+
+    make_keys();
+    printf("%d keys, %d random lookups\n", NUM_KEYS, NUM_LOOKUPS);
+
+    bench_radix();
+    bench_compact();
+    bench_hybrid();
+    bench_hope();
+    bench_diff();
+    bench_churn(0);
+    bench_churn(1);
+    bench_codegen();
+
+    for (i = 0; i < NUM_KEYS; i++) {
+        free(keys[i]);
+    }
+    free(keys);
+    return 0;
+}
+
+/* gcc -O2 -Wall bench.c -o bench */
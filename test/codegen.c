@@ -0,0 +1,36 @@
+#include <stdio.h>
+#include "../src/grat_radix_trie.h"
+#include "../src/grat_radix_trie_codegen.h"
+
+/*
+ * build-time tool: reads keys from stdin, one per line, and writes C matchers for them to stdout
+ *
+ *      ./codegen http_header < http_headers.txt > http_headers.h
+ */
+
+int
+main(int argc, char **argv) {
+    radix_t *trie = trie_new();
+    char line[1024];
+    size_t len;
+    int result;
+
+    if (argc != 2) {
+        fprintf(stderr, "usage: %s name < keys > name.h\n", argv[0]);
+        return 1;
+    }
+
+    while (fgets(line, sizeof(line), stdin) != NULL) {
+        len = strcspn(line, "\r\n");
+        line[len] = 0;
+        if (len > 0) {
+            trie_set_key(trie, line, "");
+        }
+    }
+
+    result = trie_codegen(trie, argv[1], stdout);
+    trie_destroy(trie);
+    return result != 0;
+}
+
+/* gcc -O2 -Wall codegen.c -o codegen */
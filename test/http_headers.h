@@ -0,0 +1,1060 @@
+// generated by trie_codegen from a trie of 48 keys, do not edit
+//
+//    0  "accept"
+//    1  "accept-charset"
+//    2  "accept-encoding"
+//    3  "accept-language"
+//    4  "accept-ranges"
+//    5  "age"
+//    6  "allow"
+//    7  "authorization"
+//    8  "cache-control"
+//    9  "connection"
+//   10  "content-encoding"
+//   11  "content-language"
+//   12  "content-length"
+//   13  "content-location"
+//   14  "content-range"
+//   15  "content-type"
+//   16  "cookie"
+//   17  "date"
+//   18  "etag"
+//   19  "expect"
+//   20  "expires"
+//   21  "from"
+//   22  "host"
+//   23  "if-match"
+//   24  "if-modified-since"
+//   25  "if-none-match"
+//   26  "if-range"
+//   27  "if-unmodified-since"
+//   28  "last-modified"
+//   29  "location"
+//   30  "max-forwards"
+//   31  "pragma"
+//   32  "proxy-authenticate"
+//   33  "proxy-authorization"
+//   34  "range"
+//   35  "referer"
+//   36  "retry-after"
+//   37  "server"
+//   38  "set-cookie"
+//   39  "te"
+//   40  "trailer"
+//   41  "transfer-encoding"
+//   42  "upgrade"
+//   43  "user-agent"
+//   44  "vary"
+//   45  "via"
+//   46  "warning"
+//   47  "www-authenticate"
+
+#include <stddef.h>
+#include <string.h>
+
+static inline int
+http_header (const char *key, size_t len) {
+    if (len == 0) {
+        return -1;
+    }
+    switch ((unsigned char)key[0]) {
+    case 'a':
+        if (len == 1) {
+            return -1;
+        }
+        switch ((unsigned char)key[1]) {
+        case 'c':
+            if (len >= 6 && memcmp(key + 2, "cept", 4) == 0) {
+                if (len == 6) {
+                    return 0;
+                }
+                switch ((unsigned char)key[6]) {
+                case '-':
+                    if (len == 7) {
+                        return -1;
+                    }
+                    switch ((unsigned char)key[7]) {
+                    case 'c':
+                        if (len >= 14 && memcmp(key + 8, "hars", 4) == 0 &&
+                                memcmp(key + 12, "et", 2) == 0) {
+                            return len == 14 ? 1 : -1;
+                        }
+                        return -1;
+                    case 'e':
+                        if (len >= 15 && memcmp(key + 8, "ncod", 4) == 0 &&
+                                memcmp(key + 12, "in", 2) == 0 &&
+                                memcmp(key + 14, "g", 1) == 0) {
+                            return len == 15 ? 2 : -1;
+                        }
+                        return -1;
+                    case 'l':
+                        if (len >= 15 && memcmp(key + 8, "angu", 4) == 0 &&
+                                memcmp(key + 12, "ag", 2) == 0 &&
+                                memcmp(key + 14, "e", 1) == 0) {
+                            return len == 15 ? 3 : -1;
+                        }
+                        return -1;
+                    case 'r':
+                        if (len >= 13 && memcmp(key + 8, "ange", 4) == 0 &&
+                                memcmp(key + 12, "s", 1) == 0) {
+                            return len == 13 ? 4 : -1;
+                        }
+                        return -1;
+                    }
+                    return -1;
+                }
+                return -1;
+            }
+            return -1;
+        case 'g':
+            if (len >= 3 && memcmp(key + 2, "e", 1) == 0) {
+                return len == 3 ? 5 : -1;
+            }
+            return -1;
+        case 'l':
+            if (len >= 5 && memcmp(key + 2, "lo", 2) == 0 &&
+                    memcmp(key + 4, "w", 1) == 0) {
+                return len == 5 ? 6 : -1;
+            }
+            return -1;
+        case 'u':
+            if (len >= 13 && memcmp(key + 2, "thorizat", 8) == 0 &&
+                    memcmp(key + 10, "io", 2) == 0 &&
+                    memcmp(key + 12, "n", 1) == 0) {
+                return len == 13 ? 7 : -1;
+            }
+            return -1;
+        }
+        return -1;
+    case 'c':
+        if (len == 1) {
+            return -1;
+        }
+        switch ((unsigned char)key[1]) {
+        case 'a':
+            if (len >= 13 && memcmp(key + 2, "che-cont", 8) == 0 &&
+                    memcmp(key + 10, "ro", 2) == 0 &&
+                    memcmp(key + 12, "l", 1) == 0) {
+                return len == 13 ? 8 : -1;
+            }
+            return -1;
+        case 'o':
+            if (len == 2) {
+                return -1;
+            }
+            switch ((unsigned char)key[2]) {
+            case 'n':
+                if (len == 3) {
+                    return -1;
+                }
+                switch ((unsigned char)key[3]) {
+                case 'n':
+                    if (len >= 10 && memcmp(key + 4, "ecti", 4) == 0 &&
+                            memcmp(key + 8, "on", 2) == 0) {
+                        return len == 10 ? 9 : -1;
+                    }
+                    return -1;
+                case 't':
+                    if (len >= 8 && memcmp(key + 4, "ent-", 4) == 0) {
+                        if (len == 8) {
+                            return -1;
+                        }
+                        switch ((unsigned char)key[8]) {
+                        case 'e':
+                            if (len >= 16 && memcmp(key + 9, "ncod", 4) == 0 &&
+                                    memcmp(key + 13, "in", 2) == 0 &&
+                                    memcmp(key + 15, "g", 1) == 0) {
+                                return len == 16 ? 10 : -1;
+                            }
+                            return -1;
+                        case 'l':
+                            if (len == 9) {
+                                return -1;
+                            }
+                            switch ((unsigned char)key[9]) {
+                            case 'a':
+                                if (len >= 16 && memcmp(key + 10, "ngua", 4) == 0 &&
+                                        memcmp(key + 14, "ge", 2) == 0) {
+                                    return len == 16 ? 11 : -1;
+                                }
+                                return -1;
+                            case 'e':
+                                if (len >= 14 && memcmp(key + 10, "ngth", 4) == 0) {
+                                    return len == 14 ? 12 : -1;
+                                }
+                                return -1;
+                            case 'o':
+                                if (len >= 16 && memcmp(key + 10, "cati", 4) == 0 &&
+                                        memcmp(key + 14, "on", 2) == 0) {
+                                    return len == 16 ? 13 : -1;
+                                }
+                                return -1;
+                            }
+                            return -1;
+                        case 'r':
+                            if (len >= 13 && memcmp(key + 9, "ange", 4) == 0) {
+                                return len == 13 ? 14 : -1;
+                            }
+                            return -1;
+                        case 't':
+                            if (len >= 12 && memcmp(key + 9, "yp", 2) == 0 &&
+                                    memcmp(key + 11, "e", 1) == 0) {
+                                return len == 12 ? 15 : -1;
+                            }
+                            return -1;
+                        }
+                        return -1;
+                    }
+                    return -1;
+                }
+                return -1;
+            case 'o':
+                if (len >= 6 && memcmp(key + 3, "ki", 2) == 0 &&
+                        memcmp(key + 5, "e", 1) == 0) {
+                    return len == 6 ? 16 : -1;
+                }
+                return -1;
+            }
+            return -1;
+        }
+        return -1;
+    case 'd':
+        if (len >= 4 && memcmp(key + 1, "at", 2) == 0 &&
+                memcmp(key + 3, "e", 1) == 0) {
+            return len == 4 ? 17 : -1;
+        }
+        return -1;
+    case 'e':
+        if (len == 1) {
+            return -1;
+        }
+        switch ((unsigned char)key[1]) {
+        case 't':
+            if (len >= 4 && memcmp(key + 2, "ag", 2) == 0) {
+                return len == 4 ? 18 : -1;
+            }
+            return -1;
+        case 'x':
+            if (len >= 3 && memcmp(key + 2, "p", 1) == 0) {
+                if (len == 3) {
+                    return -1;
+                }
+                switch ((unsigned char)key[3]) {
+                case 'e':
+                    if (len >= 6 && memcmp(key + 4, "ct", 2) == 0) {
+                        return len == 6 ? 19 : -1;
+                    }
+                    return -1;
+                case 'i':
+                    if (len >= 7 && memcmp(key + 4, "re", 2) == 0 &&
+                            memcmp(key + 6, "s", 1) == 0) {
+                        return len == 7 ? 20 : -1;
+                    }
+                    return -1;
+                }
+                return -1;
+            }
+            return -1;
+        }
+        return -1;
+    case 'f':
+        if (len >= 4 && memcmp(key + 1, "ro", 2) == 0 &&
+                memcmp(key + 3, "m", 1) == 0) {
+            return len == 4 ? 21 : -1;
+        }
+        return -1;
+    case 'h':
+        if (len >= 4 && memcmp(key + 1, "os", 2) == 0 &&
+                memcmp(key + 3, "t", 1) == 0) {
+            return len == 4 ? 22 : -1;
+        }
+        return -1;
+    case 'i':
+        if (len >= 3 && memcmp(key + 1, "f-", 2) == 0) {
+            if (len == 3) {
+                return -1;
+            }
+            switch ((unsigned char)key[3]) {
+            case 'm':
+                if (len == 4) {
+                    return -1;
+                }
+                switch ((unsigned char)key[4]) {
+                case 'a':
+                    if (len >= 8 && memcmp(key + 5, "tc", 2) == 0 &&
+                            memcmp(key + 7, "h", 1) == 0) {
+                        return len == 8 ? 23 : -1;
+                    }
+                    return -1;
+                case 'o':
+                    if (len >= 17 && memcmp(key + 5, "dified-s", 8) == 0 &&
+                            memcmp(key + 13, "ince", 4) == 0) {
+                        return len == 17 ? 24 : -1;
+                    }
+                    return -1;
+                }
+                return -1;
+            case 'n':
+                if (len >= 13 && memcmp(key + 4, "one-matc", 8) == 0 &&
+                        memcmp(key + 12, "h", 1) == 0) {
+                    return len == 13 ? 25 : -1;
+                }
+                return -1;
+            case 'r':
+                if (len >= 8 && memcmp(key + 4, "ange", 4) == 0) {
+                    return len == 8 ? 26 : -1;
+                }
+                return -1;
+            case 'u':
+                if (len >= 19 && memcmp(key + 4, "nmodifie", 8) == 0 &&
+                        memcmp(key + 12, "d-si", 4) == 0 &&
+                        memcmp(key + 16, "nc", 2) == 0 &&
+                        memcmp(key + 18, "e", 1) == 0) {
+                    return len == 19 ? 27 : -1;
+                }
+                return -1;
+            }
+            return -1;
+        }
+        return -1;
+    case 'l':
+        if (len == 1) {
+            return -1;
+        }
+        switch ((unsigned char)key[1]) {
+        case 'a':
+            if (len >= 13 && memcmp(key + 2, "st-modif", 8) == 0 &&
+                    memcmp(key + 10, "ie", 2) == 0 &&
+                    memcmp(key + 12, "d", 1) == 0) {
+                return len == 13 ? 28 : -1;
+            }
+            return -1;
+        case 'o':
+            if (len >= 8 && memcmp(key + 2, "cati", 4) == 0 &&
+                    memcmp(key + 6, "on", 2) == 0) {
+                return len == 8 ? 29 : -1;
+            }
+            return -1;
+        }
+        return -1;
+    case 'm':
+        if (len >= 12 && memcmp(key + 1, "ax-forwa", 8) == 0 &&
+                memcmp(key + 9, "rd", 2) == 0 &&
+                memcmp(key + 11, "s", 1) == 0) {
+            return len == 12 ? 30 : -1;
+        }
+        return -1;
+    case 'p':
+        if (len >= 2 && memcmp(key + 1, "r", 1) == 0) {
+            if (len == 2) {
+                return -1;
+            }
+            switch ((unsigned char)key[2]) {
+            case 'a':
+                if (len >= 6 && memcmp(key + 3, "gm", 2) == 0 &&
+                        memcmp(key + 5, "a", 1) == 0) {
+                    return len == 6 ? 31 : -1;
+                }
+                return -1;
+            case 'o':
+                if (len >= 10 && memcmp(key + 3, "xy-a", 4) == 0 &&
+                        memcmp(key + 7, "ut", 2) == 0 &&
+                        memcmp(key + 9, "h", 1) == 0) {
+                    if (len == 10) {
+                        return -1;
+                    }
+                    switch ((unsigned char)key[10]) {
+                    case 'e':
+                        if (len >= 18 && memcmp(key + 11, "ntic", 4) == 0 &&
+                                memcmp(key + 15, "at", 2) == 0 &&
+                                memcmp(key + 17, "e", 1) == 0) {
+                            return len == 18 ? 32 : -1;
+                        }
+                        return -1;
+                    case 'o':
+                        if (len >= 19 && memcmp(key + 11, "rization", 8) == 0) {
+                            return len == 19 ? 33 : -1;
+                        }
+                        return -1;
+                    }
+                    return -1;
+                }
+                return -1;
+            }
+            return -1;
+        }
+        return -1;
+    case 'r':
+        if (len == 1) {
+            return -1;
+        }
+        switch ((unsigned char)key[1]) {
+        case 'a':
+            if (len >= 5 && memcmp(key + 2, "ng", 2) == 0 &&
+                    memcmp(key + 4, "e", 1) == 0) {
+                return len == 5 ? 34 : -1;
+            }
+            return -1;
+        case 'e':
+            if (len == 2) {
+                return -1;
+            }
+            switch ((unsigned char)key[2]) {
+            case 'f':
+                if (len >= 7 && memcmp(key + 3, "erer", 4) == 0) {
+                    return len == 7 ? 35 : -1;
+                }
+                return -1;
+            case 't':
+                if (len >= 11 && memcmp(key + 3, "ry-after", 8) == 0) {
+                    return len == 11 ? 36 : -1;
+                }
+                return -1;
+            }
+            return -1;
+        }
+        return -1;
+    case 's':
+        if (len >= 2 && memcmp(key + 1, "e", 1) == 0) {
+            if (len == 2) {
+                return -1;
+            }
+            switch ((unsigned char)key[2]) {
+            case 'r':
+                if (len >= 6 && memcmp(key + 3, "ve", 2) == 0 &&
+                        memcmp(key + 5, "r", 1) == 0) {
+                    return len == 6 ? 37 : -1;
+                }
+                return -1;
+            case 't':
+                if (len >= 10 && memcmp(key + 3, "-coo", 4) == 0 &&
+                        memcmp(key + 7, "ki", 2) == 0 &&
+                        memcmp(key + 9, "e", 1) == 0) {
+                    return len == 10 ? 38 : -1;
+                }
+                return -1;
+            }
+            return -1;
+        }
+        return -1;
+    case 't':
+        if (len == 1) {
+            return -1;
+        }
+        switch ((unsigned char)key[1]) {
+        case 'e':
+            return len == 2 ? 39 : -1;
+        case 'r':
+            if (len >= 3 && memcmp(key + 2, "a", 1) == 0) {
+                if (len == 3) {
+                    return -1;
+                }
+                switch ((unsigned char)key[3]) {
+                case 'i':
+                    if (len >= 7 && memcmp(key + 4, "le", 2) == 0 &&
+                            memcmp(key + 6, "r", 1) == 0) {
+                        return len == 7 ? 40 : -1;
+                    }
+                    return -1;
+                case 'n':
+                    if (len >= 17 && memcmp(key + 4, "sfer-enc", 8) == 0 &&
+                            memcmp(key + 12, "odin", 4) == 0 &&
+                            memcmp(key + 16, "g", 1) == 0) {
+                        return len == 17 ? 41 : -1;
+                    }
+                    return -1;
+                }
+                return -1;
+            }
+            return -1;
+        }
+        return -1;
+    case 'u':
+        if (len == 1) {
+            return -1;
+        }
+        switch ((unsigned char)key[1]) {
+        case 'p':
+            if (len >= 7 && memcmp(key + 2, "grad", 4) == 0 &&
+                    memcmp(key + 6, "e", 1) == 0) {
+                return len == 7 ? 42 : -1;
+            }
+            return -1;
+        case 's':
+            if (len >= 10 && memcmp(key + 2, "er-agent", 8) == 0) {
+                return len == 10 ? 43 : -1;
+            }
+            return -1;
+        }
+        return -1;
+    case 'v':
+        if (len == 1) {
+            return -1;
+        }
+        switch ((unsigned char)key[1]) {
+        case 'a':
+            if (len >= 4 && memcmp(key + 2, "ry", 2) == 0) {
+                return len == 4 ? 44 : -1;
+            }
+            return -1;
+        case 'i':
+            if (len >= 3 && memcmp(key + 2, "a", 1) == 0) {
+                return len == 3 ? 45 : -1;
+            }
+            return -1;
+        }
+        return -1;
+    case 'w':
+        if (len == 1) {
+            return -1;
+        }
+        switch ((unsigned char)key[1]) {
+        case 'a':
+            if (len >= 7 && memcmp(key + 2, "rnin", 4) == 0 &&
+                    memcmp(key + 6, "g", 1) == 0) {
+                return len == 7 ? 46 : -1;
+            }
+            return -1;
+        case 'w':
+            if (len >= 16 && memcmp(key + 2, "w-authen", 8) == 0 &&
+                    memcmp(key + 10, "tica", 4) == 0 &&
+                    memcmp(key + 14, "te", 2) == 0) {
+                return len == 16 ? 47 : -1;
+            }
+            return -1;
+        }
+        return -1;
+    }
+    return -1;
+}
+
+static inline int
+http_header_prefix (const char *key, size_t len, size_t *match_len) {
+    if (len == 0) {
+        return -1;
+    }
+    switch ((unsigned char)key[0]) {
+    case 'a':
+        if (len == 1) {
+            return -1;
+        }
+        switch ((unsigned char)key[1]) {
+        case 'c':
+            if (len >= 6 && memcmp(key + 2, "cept", 4) == 0) {
+                if (len == 6) {
+                    *match_len = 6;
+                    return 0;
+                }
+                switch ((unsigned char)key[6]) {
+                case '-':
+                    if (len == 7) {
+                        *match_len = 6;
+                        return 0;
+                    }
+                    switch ((unsigned char)key[7]) {
+                    case 'c':
+                        if (len >= 14 && memcmp(key + 8, "hars", 4) == 0 &&
+                                memcmp(key + 12, "et", 2) == 0) {
+                            *match_len = 14;
+                            return 1;
+                        }
+                        *match_len = 6;
+                        return 0;
+                    case 'e':
+                        if (len >= 15 && memcmp(key + 8, "ncod", 4) == 0 &&
+                                memcmp(key + 12, "in", 2) == 0 &&
+                                memcmp(key + 14, "g", 1) == 0) {
+                            *match_len = 15;
+                            return 2;
+                        }
+                        *match_len = 6;
+                        return 0;
+                    case 'l':
+                        if (len >= 15 && memcmp(key + 8, "angu", 4) == 0 &&
+                                memcmp(key + 12, "ag", 2) == 0 &&
+                                memcmp(key + 14, "e", 1) == 0) {
+                            *match_len = 15;
+                            return 3;
+                        }
+                        *match_len = 6;
+                        return 0;
+                    case 'r':
+                        if (len >= 13 && memcmp(key + 8, "ange", 4) == 0 &&
+                                memcmp(key + 12, "s", 1) == 0) {
+                            *match_len = 13;
+                            return 4;
+                        }
+                        *match_len = 6;
+                        return 0;
+                    }
+                    *match_len = 6;
+                    return 0;
+                }
+                *match_len = 6;
+                return 0;
+            }
+            return -1;
+        case 'g':
+            if (len >= 3 && memcmp(key + 2, "e", 1) == 0) {
+                *match_len = 3;
+                return 5;
+            }
+            return -1;
+        case 'l':
+            if (len >= 5 && memcmp(key + 2, "lo", 2) == 0 &&
+                    memcmp(key + 4, "w", 1) == 0) {
+                *match_len = 5;
+                return 6;
+            }
+            return -1;
+        case 'u':
+            if (len >= 13 && memcmp(key + 2, "thorizat", 8) == 0 &&
+                    memcmp(key + 10, "io", 2) == 0 &&
+                    memcmp(key + 12, "n", 1) == 0) {
+                *match_len = 13;
+                return 7;
+            }
+            return -1;
+        }
+        return -1;
+    case 'c':
+        if (len == 1) {
+            return -1;
+        }
+        switch ((unsigned char)key[1]) {
+        case 'a':
+            if (len >= 13 && memcmp(key + 2, "che-cont", 8) == 0 &&
+                    memcmp(key + 10, "ro", 2) == 0 &&
+                    memcmp(key + 12, "l", 1) == 0) {
+                *match_len = 13;
+                return 8;
+            }
+            return -1;
+        case 'o':
+            if (len == 2) {
+                return -1;
+            }
+            switch ((unsigned char)key[2]) {
+            case 'n':
+                if (len == 3) {
+                    return -1;
+                }
+                switch ((unsigned char)key[3]) {
+                case 'n':
+                    if (len >= 10 && memcmp(key + 4, "ecti", 4) == 0 &&
+                            memcmp(key + 8, "on", 2) == 0) {
+                        *match_len = 10;
+                        return 9;
+                    }
+                    return -1;
+                case 't':
+                    if (len >= 8 && memcmp(key + 4, "ent-", 4) == 0) {
+                        if (len == 8) {
+                            return -1;
+                        }
+                        switch ((unsigned char)key[8]) {
+                        case 'e':
+                            if (len >= 16 && memcmp(key + 9, "ncod", 4) == 0 &&
+                                    memcmp(key + 13, "in", 2) == 0 &&
+                                    memcmp(key + 15, "g", 1) == 0) {
+                                *match_len = 16;
+                                return 10;
+                            }
+                            return -1;
+                        case 'l':
+                            if (len == 9) {
+                                return -1;
+                            }
+                            switch ((unsigned char)key[9]) {
+                            case 'a':
+                                if (len >= 16 && memcmp(key + 10, "ngua", 4) == 0 &&
+                                        memcmp(key + 14, "ge", 2) == 0) {
+                                    *match_len = 16;
+                                    return 11;
+                                }
+                                return -1;
+                            case 'e':
+                                if (len >= 14 && memcmp(key + 10, "ngth", 4) == 0) {
+                                    *match_len = 14;
+                                    return 12;
+                                }
+                                return -1;
+                            case 'o':
+                                if (len >= 16 && memcmp(key + 10, "cati", 4) == 0 &&
+                                        memcmp(key + 14, "on", 2) == 0) {
+                                    *match_len = 16;
+                                    return 13;
+                                }
+                                return -1;
+                            }
+                            return -1;
+                        case 'r':
+                            if (len >= 13 && memcmp(key + 9, "ange", 4) == 0) {
+                                *match_len = 13;
+                                return 14;
+                            }
+                            return -1;
+                        case 't':
+                            if (len >= 12 && memcmp(key + 9, "yp", 2) == 0 &&
+                                    memcmp(key + 11, "e", 1) == 0) {
+                                *match_len = 12;
+                                return 15;
+                            }
+                            return -1;
+                        }
+                        return -1;
+                    }
+                    return -1;
+                }
+                return -1;
+            case 'o':
+                if (len >= 6 && memcmp(key + 3, "ki", 2) == 0 &&
+                        memcmp(key + 5, "e", 1) == 0) {
+                    *match_len = 6;
+                    return 16;
+                }
+                return -1;
+            }
+            return -1;
+        }
+        return -1;
+    case 'd':
+        if (len >= 4 && memcmp(key + 1, "at", 2) == 0 &&
+                memcmp(key + 3, "e", 1) == 0) {
+            *match_len = 4;
+            return 17;
+        }
+        return -1;
+    case 'e':
+        if (len == 1) {
+            return -1;
+        }
+        switch ((unsigned char)key[1]) {
+        case 't':
+            if (len >= 4 && memcmp(key + 2, "ag", 2) == 0) {
+                *match_len = 4;
+                return 18;
+            }
+            return -1;
+        case 'x':
+            if (len >= 3 && memcmp(key + 2, "p", 1) == 0) {
+                if (len == 3) {
+                    return -1;
+                }
+                switch ((unsigned char)key[3]) {
+                case 'e':
+                    if (len >= 6 && memcmp(key + 4, "ct", 2) == 0) {
+                        *match_len = 6;
+                        return 19;
+                    }
+                    return -1;
+                case 'i':
+                    if (len >= 7 && memcmp(key + 4, "re", 2) == 0 &&
+                            memcmp(key + 6, "s", 1) == 0) {
+                        *match_len = 7;
+                        return 20;
+                    }
+                    return -1;
+                }
+                return -1;
+            }
+            return -1;
+        }
+        return -1;
+    case 'f':
+        if (len >= 4 && memcmp(key + 1, "ro", 2) == 0 &&
+                memcmp(key + 3, "m", 1) == 0) {
+            *match_len = 4;
+            return 21;
+        }
+        return -1;
+    case 'h':
+        if (len >= 4 && memcmp(key + 1, "os", 2) == 0 &&
+                memcmp(key + 3, "t", 1) == 0) {
+            *match_len = 4;
+            return 22;
+        }
+        return -1;
+    case 'i':
+        if (len >= 3 && memcmp(key + 1, "f-", 2) == 0) {
+            if (len == 3) {
+                return -1;
+            }
+            switch ((unsigned char)key[3]) {
+            case 'm':
+                if (len == 4) {
+                    return -1;
+                }
+                switch ((unsigned char)key[4]) {
+                case 'a':
+                    if (len >= 8 && memcmp(key + 5, "tc", 2) == 0 &&
+                            memcmp(key + 7, "h", 1) == 0) {
+                        *match_len = 8;
+                        return 23;
+                    }
+                    return -1;
+                case 'o':
+                    if (len >= 17 && memcmp(key + 5, "dified-s", 8) == 0 &&
+                            memcmp(key + 13, "ince", 4) == 0) {
+                        *match_len = 17;
+                        return 24;
+                    }
+                    return -1;
+                }
+                return -1;
+            case 'n':
+                if (len >= 13 && memcmp(key + 4, "one-matc", 8) == 0 &&
+                        memcmp(key + 12, "h", 1) == 0) {
+                    *match_len = 13;
+                    return 25;
+                }
+                return -1;
+            case 'r':
+                if (len >= 8 && memcmp(key + 4, "ange", 4) == 0) {
+                    *match_len = 8;
+                    return 26;
+                }
+                return -1;
+            case 'u':
+                if (len >= 19 && memcmp(key + 4, "nmodifie", 8) == 0 &&
+                        memcmp(key + 12, "d-si", 4) == 0 &&
+                        memcmp(key + 16, "nc", 2) == 0 &&
+                        memcmp(key + 18, "e", 1) == 0) {
+                    *match_len = 19;
+                    return 27;
+                }
+                return -1;
+            }
+            return -1;
+        }
+        return -1;
+    case 'l':
+        if (len == 1) {
+            return -1;
+        }
+        switch ((unsigned char)key[1]) {
+        case 'a':
+            if (len >= 13 && memcmp(key + 2, "st-modif", 8) == 0 &&
+                    memcmp(key + 10, "ie", 2) == 0 &&
+                    memcmp(key + 12, "d", 1) == 0) {
+                *match_len = 13;
+                return 28;
+            }
+            return -1;
+        case 'o':
+            if (len >= 8 && memcmp(key + 2, "cati", 4) == 0 &&
+                    memcmp(key + 6, "on", 2) == 0) {
+                *match_len = 8;
+                return 29;
+            }
+            return -1;
+        }
+        return -1;
+    case 'm':
+        if (len >= 12 && memcmp(key + 1, "ax-forwa", 8) == 0 &&
+                memcmp(key + 9, "rd", 2) == 0 &&
+                memcmp(key + 11, "s", 1) == 0) {
+            *match_len = 12;
+            return 30;
+        }
+        return -1;
+    case 'p':
+        if (len >= 2 && memcmp(key + 1, "r", 1) == 0) {
+            if (len == 2) {
+                return -1;
+            }
+            switch ((unsigned char)key[2]) {
+            case 'a':
+                if (len >= 6 && memcmp(key + 3, "gm", 2) == 0 &&
+                        memcmp(key + 5, "a", 1) == 0) {
+                    *match_len = 6;
+                    return 31;
+                }
+                return -1;
+            case 'o':
+                if (len >= 10 && memcmp(key + 3, "xy-a", 4) == 0 &&
+                        memcmp(key + 7, "ut", 2) == 0 &&
+                        memcmp(key + 9, "h", 1) == 0) {
+                    if (len == 10) {
+                        return -1;
+                    }
+                    switch ((unsigned char)key[10]) {
+                    case 'e':
+                        if (len >= 18 && memcmp(key + 11, "ntic", 4) == 0 &&
+                                memcmp(key + 15, "at", 2) == 0 &&
+                                memcmp(key + 17, "e", 1) == 0) {
+                            *match_len = 18;
+                            return 32;
+                        }
+                        return -1;
+                    case 'o':
+                        if (len >= 19 && memcmp(key + 11, "rization", 8) == 0) {
+                            *match_len = 19;
+                            return 33;
+                        }
+                        return -1;
+                    }
+                    return -1;
+                }
+                return -1;
+            }
+            return -1;
+        }
+        return -1;
+    case 'r':
+        if (len == 1) {
+            return -1;
+        }
+        switch ((unsigned char)key[1]) {
+        case 'a':
+            if (len >= 5 && memcmp(key + 2, "ng", 2) == 0 &&
+                    memcmp(key + 4, "e", 1) == 0) {
+                *match_len = 5;
+                return 34;
+            }
+            return -1;
+        case 'e':
+            if (len == 2) {
+                return -1;
+            }
+            switch ((unsigned char)key[2]) {
+            case 'f':
+                if (len >= 7 && memcmp(key + 3, "erer", 4) == 0) {
+                    *match_len = 7;
+                    return 35;
+                }
+                return -1;
+            case 't':
+                if (len >= 11 && memcmp(key + 3, "ry-after", 8) == 0) {
+                    *match_len = 11;
+                    return 36;
+                }
+                return -1;
+            }
+            return -1;
+        }
+        return -1;
+    case 's':
+        if (len >= 2 && memcmp(key + 1, "e", 1) == 0) {
+            if (len == 2) {
+                return -1;
+            }
+            switch ((unsigned char)key[2]) {
+            case 'r':
+                if (len >= 6 && memcmp(key + 3, "ve", 2) == 0 &&
+                        memcmp(key + 5, "r", 1) == 0) {
+                    *match_len = 6;
+                    return 37;
+                }
+                return -1;
+            case 't':
+                if (len >= 10 && memcmp(key + 3, "-coo", 4) == 0 &&
+                        memcmp(key + 7, "ki", 2) == 0 &&
+                        memcmp(key + 9, "e", 1) == 0) {
+                    *match_len = 10;
+                    return 38;
+                }
+                return -1;
+            }
+            return -1;
+        }
+        return -1;
+    case 't':
+        if (len == 1) {
+            return -1;
+        }
+        switch ((unsigned char)key[1]) {
+        case 'e':
+            *match_len = 2;
+            return 39;
+        case 'r':
+            if (len >= 3 && memcmp(key + 2, "a", 1) == 0) {
+                if (len == 3) {
+                    return -1;
+                }
+                switch ((unsigned char)key[3]) {
+                case 'i':
+                    if (len >= 7 && memcmp(key + 4, "le", 2) == 0 &&
+                            memcmp(key + 6, "r", 1) == 0) {
+                        *match_len = 7;
+                        return 40;
+                    }
+                    return -1;
+                case 'n':
+                    if (len >= 17 && memcmp(key + 4, "sfer-enc", 8) == 0 &&
+                            memcmp(key + 12, "odin", 4) == 0 &&
+                            memcmp(key + 16, "g", 1) == 0) {
+                        *match_len = 17;
+                        return 41;
+                    }
+                    return -1;
+                }
+                return -1;
+            }
+            return -1;
+        }
+        return -1;
+    case 'u':
+        if (len == 1) {
+            return -1;
+        }
+        switch ((unsigned char)key[1]) {
+        case 'p':
+            if (len >= 7 && memcmp(key + 2, "grad", 4) == 0 &&
+                    memcmp(key + 6, "e", 1) == 0) {
+                *match_len = 7;
+                return 42;
+            }
+            return -1;
+        case 's':
+            if (len >= 10 && memcmp(key + 2, "er-agent", 8) == 0) {
+                *match_len = 10;
+                return 43;
+            }
+            return -1;
+        }
+        return -1;
+    case 'v':
+        if (len == 1) {
+            return -1;
+        }
+        switch ((unsigned char)key[1]) {
+        case 'a':
+            if (len >= 4 && memcmp(key + 2, "ry", 2) == 0) {
+                *match_len = 4;
+                return 44;
+            }
+            return -1;
+        case 'i':
+            if (len >= 3 && memcmp(key + 2, "a", 1) == 0) {
+                *match_len = 3;
+                return 45;
+            }
+            return -1;
+        }
+        return -1;
+    case 'w':
+        if (len == 1) {
+            return -1;
+        }
+        switch ((unsigned char)key[1]) {
+        case 'a':
+            if (len >= 7 && memcmp(key + 2, "rnin", 4) == 0 &&
+                    memcmp(key + 6, "g", 1) == 0) {
+                *match_len = 7;
+                return 46;
+            }
+            return -1;
+        case 'w':
+            if (len >= 16 && memcmp(key + 2, "w-authen", 8) == 0 &&
+                    memcmp(key + 10, "tica", 4) == 0 &&
+                    memcmp(key + 14, "te", 2) == 0) {
+                *match_len = 16;
+                return 47;
+            }
+            return -1;
+        }
+        return -1;
+    }
+    return -1;
+}
@@ -1,5 +1,10 @@
 #include <stdio.h>
 #include "../src/grat_radix_trie.h"
+#include "../src/grat_radix_trie_shm.h"
+#include "../src/grat_radix_trie_compact.h"
+#include "../src/grat_radix_trie_hope.h"
+#include "../src/grat_radix_trie_codegen.h"
+#include "http_headers.h"
 
 /*
  * minimal unit testing, from http://www.jera.com/techinfo/jtns/jtn002.html
@@ -23,7 +28,6 @@ int tests_run = 0;
 radix_t *trie = NULL;
 radix_t *trie2 = NULL;
 
-/*
 static char *
 test_new_trie() {
     trie = trie_new();
@@ -39,27 +43,678 @@ test_set_get_and_delete() {
 
     trie_set_key(trie, key1, val1_in);
 
-    val1_out = trie_get_key(trie, key1);
+    val1_out = (char *)trie_get_key(trie, key1);
     mu_assert("", strcmp(val1_in, val1_out) == 0);
     mu_assert("", strcmp("not_val1", val1_out) != 0);
 
     val1_out = NULL;
-    val1_out = trie_delete_key(trie, key1);
+    val1_out = (char *)trie_delete_key(trie, key1);
     mu_assert("", strcmp(val1_in, val1_out) == 0);
 
-    val1_out = trie_get_key(trie, key1);
+    val1_out = (char *)trie_get_key(trie, key1);
     mu_assert("", val1_out == NULL);
 
     return 0;
 }
 
+static radix_agg_t
+agg_atol(void *value) {
+    return atol((char *)value);
+}
+
+static char *
+test_counts_rank_and_select() {
+    static const radix_aggregate_t sum = { 0, agg_atol, trie_aggregate_sum };
+    char key[32];
+    radix_t *counted = trie_new_aggregate(&sum);
+
+    trie_set_key(counted, "superlative", "1");
+    trie_set_key(counted, "super", "2");
+    trie_set_key(counted, "supper", "3");
+    trie_set_key(counted, "soup", "4");
+    trie_set_key(counted, "also", "5");
+
+    mu_assert("", trie_count_prefix(counted, "") == 5);
+    mu_assert("", trie_count_prefix(counted, "su") == 3);
+    mu_assert("", trie_count_prefix(counted, "supe") == 2);
+    mu_assert("", trie_count_prefix(counted, "x") == 0);
+    mu_assert("", trie_aggregate_prefix(counted, "sup") == 6);
+
+    // also, soup, super, superlative, supper
+    mu_assert("", trie_rank(counted, "also") == 0);
+    mu_assert("", trie_rank(counted, "super") == 2);
+    mu_assert("", trie_rank(counted, "superb") == 3);
+    mu_assert("", trie_rank(counted, "zzz") == 5);
+    mu_assert("", strcmp((char *)trie_select(counted, 3, key, sizeof(key)), "1") == 0);
+    mu_assert("", strcmp(key, "superlative") == 0);
+    mu_assert("", trie_select(counted, 5, key, sizeof(key)) == NULL);
+
+    // deletes merge nodes back together and keep the counts right
+    trie_delete_key(counted, "super");
+    mu_assert("", trie_count_prefix(counted, "sup") == 2);
+    mu_assert("", trie_aggregate_prefix(counted, "sup") == 4);
+    mu_assert("", strcmp((char *)trie_get_key(counted, "superlative"), "1") == 0);
+    trie_delete_key(counted, "soup");
+    mu_assert("", trie_count_prefix(counted, "s") == 2);
+    mu_assert("", trie_rank(counted, "supper") == 2);
+
+    trie_destroy(counted);
+    return 0;
+}
+
+static void *
+keep_src(void *dst_value, void *src_value) {
+    return src_value;
+}
+
+static char *
+test_set_operations() {
+    radix_t *base = trie_new();
+    radix_t *delta = trie_new();
+    radix_t *other = trie_new();
+
+    trie_set_key(base, "total", "1");
+    trie_set_key(base, "totally", "2");
+    trie_set_key(base, "tone", "3");
+    trie_set_key(delta, "tot", "4");
+    trie_set_key(delta, "total", "5");
+    trie_set_key(delta, "tonic", "6");
+    trie_set_key(delta, "zebra", "7");
+
+    trie_union(base, delta, keep_src);
+    mu_assert("", trie_count_prefix(base, "") == 6);
+    mu_assert("", trie_count_prefix(delta, "") == 0);
+    mu_assert("", strcmp((char *)trie_get_key(base, "total"), "5") == 0);
+    mu_assert("", strcmp((char *)trie_get_key(base, "tot"), "4") == 0);
+    mu_assert("", strcmp((char *)trie_get_key(base, "tonic"), "6") == 0);
+    mu_assert("", strcmp((char *)trie_get_key(base, "totally"), "2") == 0);
+    mu_assert("", trie_rank(base, "zebra") == 5);
+
+    trie_set_key(other, "to", "8");
+    trie_set_key(other, "totally", "9");
+    trie_set_key(other, "tonic", "10");
+    trie_set_key(other, "zebras", "11");
+
+    trie_difference(base, other, NULL);
+    mu_assert("", trie_count_prefix(base, "") == 4);
+    mu_assert("", trie_get_key(base, "totally") == NULL);
+    mu_assert("", strcmp((char *)trie_get_key(base, "total"), "5") == 0);
+
+    trie_set_key(other, "tone", "12");
+    trie_set_key(other, "total", "13");
+    trie_intersect(base, other, NULL, NULL);
+    mu_assert("", trie_count_prefix(base, "") == 2);
+    mu_assert("", trie_get_key(base, "tot") == NULL);
+    mu_assert("", trie_get_key(base, "zebra") == NULL);
+    mu_assert("", strcmp((char *)trie_get_key(base, "tone"), "3") == 0);
+    mu_assert("", strcmp((char *)trie_get_key(base, "total"), "5") == 0);
+    // "to" (from the split of "tone"/"total") must have been compressed back away
+    mu_assert("", base->child != NULL && strcmp(base->child->key, "to") == 0);
+    mu_assert("", base->child->child != NULL && base->child->child->right != NULL);
+
+    trie_destroy(base);
+    trie_destroy(delta);
+    trie_destroy(other);
+    return 0;
+}
+
+static int values_freed = 0;
+
+static void
+count_freed(void *value) {
+    values_freed++;
+}
+
+static char *
+test_delete_prefix() {
+    radix_t *tenants = trie_new();
+    radix_t *subtree;
+
+    trie_set_key(tenants, "acme/a", "1");
+    trie_set_key(tenants, "acme/b", "2");
+    trie_set_key(tenants, "acme/b/c", "3");
+    trie_set_key(tenants, "acne", "4");
+    trie_set_key(tenants, "bolt/a", "5");
+
+    values_freed = 0;
+    mu_assert("", trie_delete_prefix(tenants, "acme/", count_freed) == 3);
+    mu_assert("", values_freed == 3);
+    mu_assert("", trie_count_prefix(tenants, "") == 2);
+    mu_assert("", trie_get_key(tenants, "acme/a") == NULL);
+    mu_assert("", strcmp((char *)trie_get_key(tenants, "acne"), "4") == 0);
+    // "ac" lost a child, so it should have merged back into "acne"
+    mu_assert("", strcmp(tenants->child->key, "acne") == 0);
+
+    // a prefix ending part way through a node's key takes the whole node
+    mu_assert("", trie_delete_prefix(tenants, "bo", NULL) == 1);
+    mu_assert("", trie_delete_prefix(tenants, "nothing", NULL) == 0);
+
+    subtree = trie_detach_prefix(tenants, "");
+    mu_assert("", subtree != NULL && subtree->count == 1);
+    mu_assert("", trie_count_prefix(tenants, "") == 0 && tenants->child == NULL);
+    trie_free_subtree(subtree, NULL);
+
+    trie_destroy(tenants);
+    return 0;
+}
+
+static char *
+test_domains() {
+    radix_t *rules = trie_new();
+    const char *hosts[] = { "ads.eu.cdn.net", "www.example.com", "example.org" };
+    void *results[3];
+
+    trie_set_domain(rules, "example.com", "site");
+    trie_set_domain(rules, "*.example.com", "any-sub");
+    trie_set_domain(rules, "login.example.com", "login");
+    trie_set_domain(rules, "ads.*.cdn.net", "ads");
+    trie_set_domain(rules, "cdn.net", "cdn");
+
+    mu_assert("", strcmp((char *)trie_get_domain(rules, "Example.COM."), "site") == 0);
+    mu_assert("", strcmp((char *)trie_match_suffix(rules, "a.b.example.com"), "site") == 0);
+    mu_assert("", strcmp((char *)trie_match_suffix(rules, "login.example.com"), "login") == 0);
+    mu_assert("", trie_match_suffix(rules, "badexample.com") == NULL);
+    mu_assert("", trie_match_suffix(rules, "com") == NULL);
+
+    mu_assert("", strcmp((char *)trie_match_domain(rules, "www.example.com"), "any-sub") == 0);
+    mu_assert("", strcmp((char *)trie_match_domain(rules, "login.example.com"), "login") == 0);
+    mu_assert("", strcmp((char *)trie_match_domain(rules, "example.com"), "site") == 0);
+    mu_assert("", strcmp((char *)trie_match_domain(rules, "ads.us.cdn.net"), "ads") == 0);
+    mu_assert("", strcmp((char *)trie_match_domain(rules, "img.us.cdn.net"), "cdn") == 0);
+
+    mu_assert("", trie_match_domains(rules, hosts, 3, results) == 2);
+    mu_assert("", strcmp((char *)results[0], "ads") == 0 && results[2] == NULL);
+
+    trie_delete_domain(rules, "*.example.com");
+    mu_assert("", strcmp((char *)trie_match_domain(rules, "www.example.com"), "site") == 0);
+
+    trie_destroy(rules);
+    return 0;
+}
+
+static char *
+test_shm_trie() {
+    char *region = (char *)malloc(16384);
+    char *moved = (char *)malloc(16384);
+    char tiny[sizeof(radix_shm_t) + 64];
+    uint64_t val;
+    radix_shm_t *shm = trie_shm_init(region, 16384);
+
+    mu_assert("", shm != NULL);
+    mu_assert("", trie_shm_set_key(shm, "total", 1) == 0);
+    mu_assert("", trie_shm_set_key(shm, "totally", 2) == 0);
+    mu_assert("", trie_shm_set_key(shm, "tone", 3) == 0);
+    mu_assert("", trie_shm_set_key(shm, "to", 4) == 0);
+    mu_assert("", trie_shm_get_key(shm, "tone", &val) == 0 && val == 3);
+    mu_assert("", trie_shm_get_key(shm, "tot", &val) == 0 && val == 0);
+    mu_assert("", shm->count == 4);
+
+    // offsets only, so a copy at another address is the same trie
+    memcpy(moved, region, 16384);
+    shm = trie_shm_attach(moved);
+    mu_assert("", shm != NULL && trie_shm_get_key(shm, "totally", &val) == 0 && val == 2);
+    mu_assert("", trie_shm_delete_key(shm, "to") == 4);
+    mu_assert("", trie_shm_delete_key(shm, "total") == 1);
+    mu_assert("", trie_shm_get_key(shm, "totally", &val) == 0 && val == 2);
+    mu_assert("", trie_shm_get_key(shm, "tone", &val) == 0 && val == 3);
+    mu_assert("", trie_shm_get_key(trie_shm_attach(region), "to", &val) == 0 && val == 4);
+    mu_assert("", trie_shm_set_key(shm, "tone", 0) == 0);
+    mu_assert("", trie_shm_set_key(shm, "tonal", 0) == 0);
+    mu_assert("", trie_shm_get_key(shm, "tone", &val) == 0 && val == 0 && shm->count == 1);
+    // a writer that died after publishing a key but before counting it
+    shm->version++;
+    shm->count--;
+    val = 5;
+    mu_assert("", trie_shm_get_key(shm, "totally", &val) == -1 && val == 5);
+    trie_shm_recover(shm);
+    mu_assert("", trie_shm_get_key(shm, "totally", &val) == 0 && val == 2 && shm->count == 1);
+
+    // running out of room leaves the trie alone
+    shm = trie_shm_init(tiny, sizeof(tiny));
+    mu_assert("", shm != NULL);
+    mu_assert("", trie_shm_set_key(shm, "a key much too long for the space that is left", 1) == -1);
+    mu_assert("", trie_shm_get_key(shm, "a key much too long for the space that is left", &val) == 0
+            && val == 0);
+
+    free(region);
+    free(moved);
+    return 0;
+}
+
+static char compact_keys[256];
+
+static void
+collect_compact_key(const char *key, void *value) {
+    strcat(compact_keys, key);
+    strcat(compact_keys, ",");
+}
+
+static char *
+test_compact_trie() {
+    radix_compact_t *compact = trie_compact_new();
+    char *remainder;
+
+    mu_assert("", sizeof(radix_compact_node_t) <= 32);
+
+    trie_compact_set_key(compact, "superlative", "1");
+    trie_compact_set_key(compact, "super", "2");
+    trie_compact_set_key(compact, "supper", "3");
+    trie_compact_set_key(compact, "soup", "4");
+    trie_compact_set_key(compact, "http://example.com/a/rather/long/path", "5");
+    trie_compact_set_key(compact, "http://example.com/a/rather/lengthy/path", "6");
+    mu_assert("", compact->count == 6);
+    mu_assert("", strcmp((char *)trie_compact_get_key(compact, "super"), "2") == 0);
+    mu_assert("", strcmp((char *)trie_compact_get_key(compact,
+                    "http://example.com/a/rather/lengthy/path"), "6") == 0);
+    mu_assert("", trie_compact_get_key(compact, "http://example.com/a/rather/l") == NULL);
+    mu_assert("", trie_compact_get_key(compact, "sup") == NULL);
+
+    mu_assert("", strcmp((char *)trie_compact_get_longest_match(compact, "superb", &remainder),
+                "2") == 0);
+    mu_assert("", strcmp(remainder, "b") == 0);
+
+    mu_assert("", strcmp((char *)trie_compact_delete_key(compact, "super"), "2") == 0);
+    mu_assert("", strcmp((char *)trie_compact_delete_key(compact,
+                    "http://example.com/a/rather/long/path"), "5") == 0);
+    mu_assert("", trie_compact_delete_key(compact, "super") == NULL);
+    mu_assert("", strcmp((char *)trie_compact_get_key(compact,
+                    "http://example.com/a/rather/lengthy/path"), "6") == 0);
+
+    compact_keys[0] = 0;
+    mu_assert("", trie_compact_recurse(compact, collect_compact_key) == 4);
+    mu_assert("", strcmp(compact_keys,
+                "http://example.com/a/rather/lengthy/path,soup,superlative,supper,") == 0);
+
+    trie_compact_destroy(compact);
+    return 0;
+}
+
+static char *
+test_compact_relayout() {
+    radix_compact_t *compact = trie_compact_new();
+    char key[64];
+    int i, steps;
+
+    for (i = 0; i < 200; i++) {
+        sprintf(key, "http://example.com/%d/%d", i % 7, i);
+        trie_compact_set_key(compact, key, "x");
+    }
+    for (i = 0; i < 200; i += 3) {
+        sprintf(key, "http://example.com/%d/%d", i % 7, i);
+        trie_compact_delete_key(compact, key);
+    }
+
+    // run in small slices with lookups in between
+    for (steps = 0; trie_compact_relayout(compact, 10) == 0; steps++) {
+        mu_assert("", trie_compact_get_key(compact, "http://example.com/1/1") != NULL);
+    }
+    mu_assert("", steps > 1);
+    mu_assert("", compact->free_nodes == 0 && compact->label_garbage == 0);
+    // depth first: the root's first child sits right behind it
+    mu_assert("", compact->nodes[RADIX_COMPACT_ROOT].child == RADIX_COMPACT_ROOT + 1);
+
+    // writes between slices go to both layouts and leave the relayout going
+    for (steps = 0; trie_compact_relayout(compact, 10) == 0; steps++) {
+        sprintf(key, "http://example.com/%d/%d", (3 * steps + 1) % 7, 3 * steps + 1);
+        trie_compact_set_key(compact, key, "z");
+        trie_compact_set_key(compact, "late", "y");
+        trie_compact_set_key(compact, "later", "y");
+        trie_compact_delete_key(compact, "later");
+        mu_assert("", compact->relayout_nodes != NULL);
+        mu_assert("", steps < 100);
+    }
+    mu_assert("", steps > 1);
+
+    for (i = 0; i < 200; i++) {
+        sprintf(key, "http://example.com/%d/%d", i % 7, i);
+        mu_assert("", (trie_compact_get_key(compact, key) != NULL) == (i % 3 != 0));
+    }
+    mu_assert("", trie_compact_get_key(compact, "late") != NULL);
+
+    trie_compact_destroy(compact);
+    return 0;
+}
+
+static char *
+test_compact_hybrid() {
+    radix_compact_t *hybrid = trie_compact_new_hybrid(4);
+    char key[64];
+    char *remainder;
+    int i;
+
+    mu_assert("", RADIX_COMPACT_IS_BUCKET(hybrid, RADIX_COMPACT_ROOT));
+    for (i = 0; i < 40; i++) {
+        sprintf(key, "user/%d", i);
+        trie_compact_set_key(hybrid, key, "x");
+    }
+    trie_compact_set_key(hybrid, "user", "y");
+    mu_assert("", hybrid->count == 41);
+    // 41 keys can't fit in a bucket of 4, so it must have burst
+    mu_assert("", !RADIX_COMPACT_IS_BUCKET(hybrid, RADIX_COMPACT_ROOT));
+    mu_assert("", strcmp((char *)trie_compact_get_key(hybrid, "user/17"), "x") == 0);
+    mu_assert("", strcmp((char *)trie_compact_get_key(hybrid, "user"), "y") == 0);
+    mu_assert("", trie_compact_get_key(hybrid, "user/41") == NULL);
+    mu_assert("", strcmp((char *)trie_compact_get_longest_match(hybrid, "user/3/x", &remainder),
+                "x") == 0);
+    mu_assert("", strcmp(remainder, "/x") == 0);
+
+    compact_keys[0] = 0;
+    trie_compact_delete_key(hybrid, "user");
+    for (i = 2; i < 40; i++) {
+        sprintf(key, "user/%d", i);
+        mu_assert("", trie_compact_delete_key(hybrid, key) != NULL);
+    }
+    // down to two keys, everything collapses back into the root's bucket
+    mu_assert("", trie_compact_recurse(hybrid, collect_compact_key) == 2);
+    mu_assert("", strcmp(compact_keys, "user/0,user/1,") == 0);
+    mu_assert("", RADIX_COMPACT_IS_BUCKET(hybrid, RADIX_COMPACT_ROOT));
+
+    // so does a burst several levels deep
+    for (i = 0; i < 40; i++) {
+        sprintf(key, "%c/%c%d", 'a' + i % 3, 'a' + i % 5, i);
+        trie_compact_set_key(hybrid, key, "z");
+    }
+    for (i = 0; i < 40; i++) {
+        sprintf(key, "%c/%c%d", 'a' + i % 3, 'a' + i % 5, i);
+        trie_compact_delete_key(hybrid, key);
+    }
+    mu_assert("", RADIX_COMPACT_IS_BUCKET(hybrid, RADIX_COMPACT_ROOT) && hybrid->count == 2);
+
+    trie_compact_destroy(hybrid);
+    return 0;
+}
+
+static char *
+test_hope_keys() {
+    const char *sample[] = { "apple", "apricot", "banana", "band", "bandana", "can", "cane" };
+    const char *keys[] = { "ban", "apple", "cane", "band", "apricot", "zebra!", "bandana", "can" };
+    radix_hope_t *hope = trie_hope_train(sample, 7);
+    radix_t *trie = trie_new();
+    char encoded[64], decoded[64], prev[64];
+    size_t i;
+
+    mu_assert("", trie_hope_encode(hope, "apricot", encoded, sizeof(encoded))
+            == strlen(encoded));
+    mu_assert("", trie_hope_decode(hope, encoded, decoded, sizeof(decoded)) == 7);
+    mu_assert("", strcmp(decoded, "apricot") == 0);
+    // frequent letters get short codes, so trained keys shrink
+    mu_assert("", strlen(encoded) < strlen("apricot"));
+
+    for (i = 0; i < 8; i++) {
+        trie_hope_set_key(trie, hope, keys[i], (void *)keys[i]);
+    }
+    mu_assert("", strcmp((char *)trie_hope_get_key(trie, hope, "band"), "band") == 0);
+    mu_assert("", trie_hope_get_key(trie, hope, "bandan") == NULL);
+
+    // encoded keys sort like the originals, "zebra!" included even though it wasn't trained on
+    prev[0] = 0;
+    for (i = 0; i < trie->count; i++) {
+        trie_hope_select(trie, hope, i, decoded, sizeof(decoded));
+        mu_assert("", strcmp(prev, decoded) < 0);
+        strcpy(prev, decoded);
+    }
+    mu_assert("", strcmp(prev, "zebra!") == 0);
+    mu_assert("", trie_hope_rank(trie, hope, "band") == 3);
+
+    mu_assert("", trie_hope_count_prefix(trie, hope, "ban") == 3);
+    mu_assert("", trie_hope_count_prefix(trie, hope, "ap") == 2);
+    mu_assert("", trie_hope_count_prefix(trie, hope, "c") == 2);
+    mu_assert("", trie_hope_count_prefix(trie, hope, "") == 8);
+    mu_assert("", trie_hope_count_prefix(trie, hope, "x") == 0);
+
+    trie_hope_delete_key(trie, hope, "band");
+    mu_assert("", trie_hope_count_prefix(trie, hope, "band") == 1);
+
+    trie_destroy(trie);
+    trie_hope_destroy(hope);
+    return 0;
+}
+
+static char *
+test_negative_filter() {
+    radix_t *trie = trie_new();
+    radix_t *other = trie_new();
+    radix_filter_stats_t stats;
+    char key[32];
+    int i;
+
+    mu_assert("", trie_filter_stats(trie, &stats) == -1);
+    trie_set_key(trie, "before", "x");
+    trie_rebuild_filter(trie);
+    mu_assert("", trie_filter_stats(trie, &stats) == -1);
+    trie_enable_filter(trie);
+    trie_count_filter_lookups(trie, 1);
+    trie_set_key(trie, "no value", NULL);
+    for (i = 0; i < 1000; i++) {
+        sprintf(key, "key/%d", i);
+        trie_set_key(trie, key, "x");
+    }
+
+    // no false negatives, and almost every miss is answered by the filter
+    mu_assert("", trie_get_key(trie, "before") != NULL);
+    mu_assert("", trie_get_key(trie, "no value") == NULL);
+    for (i = 0; i < 1000; i++) {
+        sprintf(key, "key/%d", i);
+        mu_assert("", trie_get_key(trie, key) != NULL);
+        sprintf(key, "key/%d", i + 1000);
+        mu_assert("", trie_get_key(trie, key) == NULL);
+    }
+    mu_assert("", trie_filter_stats(trie, &stats) == 0);
+    mu_assert("", stats.lookups == 2002 && stats.rejected + stats.false_positives == 1001);
+    mu_assert("", stats.false_positive_rate < 0.05 && stats.hit_rate > 0.45);
+    // it grew with the keys
+    mu_assert("", stats.rebuilds > 0 && stats.memory > 1000);
+
+    // deleting most of the keys makes it rebuild smaller
+    for (i = 0; i < 900; i++) {
+        sprintf(key, "key/%d", i);
+        trie_delete_key(trie, key);
+    }
+    trie_filter_stats(trie, &stats);
+    mu_assert("", stats.memory < 500);
+    mu_assert("", trie_get_key(trie, "key/950") != NULL && trie_get_key(trie, "key/5") == NULL);
+
+    // keys arriving through a union are found too
+    trie_set_key(other, "grafted/key", "y");
+    trie_union(trie, other, NULL);
+    mu_assert("", trie_get_key(trie, "grafted/key") != NULL);
+
+    trie_destroy(other);
+    trie_destroy(trie);
+    return 0;
+}
+
+static char diff_keys[256];
+
+static void
+collect_diff_key(const char *key, void *a_value, void *b_value) {
+    strcat(diff_keys, a_value == NULL ? "+" : b_value == NULL ? "-" : "~");
+    strcat(diff_keys, key);
+    strcat(diff_keys, ",");
+}
+
+static size_t
+encode_string(void *value, char *buf, size_t buf_len) {
+    size_t len = strlen((char *)value);
+
+    if (len <= buf_len) {
+        memcpy(buf, value, len);
+    }
+    return len;
+}
+
+static void *
+decode_string(const char *buf, size_t len) {
+    return strndup(buf, len);
+}
+
+static char *
+test_diff_and_delta() {
+    const char *keys[] = { "alpha", "alphabet", "beta", "betamax", "gamma", "gamut" };
+    radix_t *a = trie_new();
+    radix_t *b = trie_new();
+    radix_t *replica = trie_new();
+    char *delta;
+    size_t len;
+    int i;
+
+    trie_enable_hashing(a, trie_hash_string);
+    trie_enable_hashing(replica, trie_hash_string);
+    for (i = 0; i < 6; i++) {
+        trie_set_key(a, keys[i], (void *)keys[i]);
+        trie_set_key(replica, keys[i], strdup(keys[i]));
+    }
+    // hashing can be turned on after the fact, and equal tries hash the same
+    for (i = 5; i >= 0; i--) {
+        trie_set_key(b, keys[i], (void *)keys[i]);
+    }
+    trie_enable_hashing(b, trie_hash_string);
+    mu_assert("", a->hash == b->hash && a->hash == replica->hash);
+    mu_assert("", trie_diff(a, b, NULL) == 0);
+
+    // "alph" splits a node that a doesn't split, "betamax" merges into its parent when "beta" goes
+    trie_set_key(b, "alph", "new");
+    trie_delete_key(b, "beta");
+    trie_set_key(b, "gamut", "changed");
+    trie_set_key(b, "gammas", "new");
+    mu_assert("", a->hash != b->hash);
+
+    diff_keys[0] = 0;
+    mu_assert("", trie_diff(a, b, collect_diff_key) == 4);
+    mu_assert("", strcmp(diff_keys, "+alph,-beta,+gammas,~gamut,") == 0);
+
+    // a delta makes a replica of a into a copy of b
+    delta = trie_delta(a, b, encode_string, &len);
+    mu_assert("", trie_apply_delta(replica, delta, len, decode_string, free) == 4);
+    mu_assert("", replica->hash == b->hash && trie_diff(replica, b, NULL) == 0);
+    mu_assert("", strcmp((char *)trie_get_key(replica, "gamut"), "changed") == 0);
+    mu_assert("", trie_apply_delta(replica, delta, len - 1, decode_string, free) == -1);
+    free(delta);
+
+    trie_delete_prefix(replica, "", free);
+    trie_destroy(replica);
+    trie_destroy(b);
+    trie_destroy(a);
+    return 0;
+}
+
+static char *
+test_tombstones() {
+    radix_t *trie = trie_new();
+    radix_t *eager = trie_new();
+    char key[32];
+    int i;
+
+    trie_enable_hashing(trie, trie_hash_pointer);
+    trie_enable_hashing(eager, trie_hash_pointer);
+    trie_enable_tombstones(trie);
+    for (i = 0; i < 100; i++) {
+        sprintf(key, "session/%d", i);
+        trie_set_key(trie, key, "x");
+        trie_set_key(eager, key, "x");
+    }
+
+    for (i = 0; i < 100; i += 2) {
+        sprintf(key, "session/%d", i);
+        mu_assert("", trie_delete_key(trie, key) != NULL);
+        trie_delete_key(eager, key);
+    }
+    // the keys are gone right away, the nodes only once maintenance is done
+    mu_assert("", trie->count == 50 && trie_get_key(trie, "session/4") == NULL);
+    mu_assert("", trie_count_prefix(trie, "session/1") == 6);
+    mu_assert("", RADIX_INFO(trie)->dirty != NULL && trie->hash != eager->hash);
+
+    // a tombstone can be brought back before it is cleaned up
+    trie_set_key(trie, "session/0", "y");
+    trie_set_key(eager, "session/0", "y");
+
+    mu_assert("", trie_maintain(trie, 10) == 0);
+    while (trie_maintain(trie, 10) == 0) {
+        continue;
+    }
+    mu_assert("", RADIX_INFO(trie)->dirty == NULL);
+    // which leaves the same nodes eager deletes would have
+    mu_assert("", trie->hash == eager->hash && trie_diff(trie, eager, NULL) == 0);
+    mu_assert("", strcmp((char *)trie_get_key(trie, "session/0"), "y") == 0);
+
+    trie_destroy(eager);
+    trie_destroy(trie);
+    return 0;
+}
+
+static char *
+test_codegen() {
+    radix_t *trie = trie_new();
+    FILE *out = tmpfile();
+    char source[4096];
+    size_t len, match_len;
+
+    // http_headers.h was generated by codegen.c from http_headers.txt
+    mu_assert("", http_header("accept", 6) == 0);
+    mu_assert("", http_header("content-length", 14) == 12);
+    mu_assert("", http_header("www-authenticate", 16) == 47);
+    mu_assert("", http_header("content-len", 11) == -1);
+    mu_assert("", http_header("content-lengthy", 15) == -1);
+    mu_assert("", http_header("", 0) == -1);
+    // lengths are explicit, so keys don't need to be terminated
+    mu_assert("", http_header("hostname", 4) == 22);
+
+    mu_assert("", http_header_prefix("content-length: 42", 18, &match_len) == 12);
+    mu_assert("", match_len == 14);
+    mu_assert("", http_header_prefix("accept-encodin", 14, &match_len) == 0 && match_len == 6);
+    mu_assert("", http_header_prefix("xyz", 3, &match_len) == -1);
+
+    // ordinals are the keys' ranks in the trie they came from
+    trie_set_key(trie, "get", "x");
+    trie_set_key(trie, "getx", "x");
+    trie_set_key(trie, "put", "x");
+    mu_assert("", trie_codegen(trie, "verb", out) == 0);
+    rewind(out);
+    len = fread(source, 1, sizeof(source) - 1, out);
+    source[len] = 0;
+    mu_assert("", strstr(source, "verb_prefix (const char *key, size_t len") != NULL);
+    mu_assert("", strstr(source, "return len == 4 ? 1 : -1;") != NULL);
+    fclose(out);
+    trie_destroy(trie);
+
+    // keys that were deleted or set to NULL don't match as their parent's ordinal
+    trie = trie_new();
+    out = tmpfile();
+    trie_enable_tombstones(trie);
+    trie_set_key(trie, "get", "x");
+    trie_set_key(trie, "getter", "x");
+    trie_delete_key(trie, "getter");
+    trie_set_key(trie, "gets", NULL);
+    mu_assert("", trie_codegen(trie, "verb", out) == 0);
+    rewind(out);
+    len = fread(source, 1, sizeof(source) - 1, out);
+    source[len] = 0;
+    mu_assert("", strstr(source, "getter") == NULL && strstr(source, "? 0 : -1") == NULL);
+
+    fclose(out);
+    trie_destroy(trie);
+    return 0;
+}
+
 static char *
 all_tests() {
     mu_run_test(test_new_trie);
     mu_run_test(test_set_get_and_delete);
+    mu_run_test(test_counts_rank_and_select);
+    mu_run_test(test_set_operations);
+    mu_run_test(test_delete_prefix);
+    mu_run_test(test_domains);
+    mu_run_test(test_hope_keys);
+    mu_run_test(test_negative_filter);
+    mu_run_test(test_diff_and_delta);
+    mu_run_test(test_tombstones);
+    mu_run_test(test_codegen);
+    mu_run_test(test_shm_trie);
+    mu_run_test(test_compact_trie);
+    mu_run_test(test_compact_relayout);
+    mu_run_test(test_compact_hybrid);
     return 0;
 }
-*/
 
 void
 dump_subtree (radix_t *node, const int depth) {
@@ -88,7 +743,6 @@ dump_subtree (radix_t *node, const int depth) {
 int
 main(int argc, char **argv) {
     char *value;
-    /*
     char *result = all_tests();
     if (result != 0) {
         printf("SOME TESTS FAILED\n");
@@ -97,7 +751,7 @@ main(int argc, char **argv) {
     }
     printf("Tests run: %d\n", tests_run);
     printf("\n");
-    */
+    trie_destroy(trie);
 
     trie = trie_new();
 
@@ -125,8 +779,7 @@ main(int argc, char **argv) {
     trie_destroy(trie);
 
 
-    //return result != 0;
-    return 0;
+    return result != 0;
 }
 
 /* gcc -g -Wall test.c -o test */